@@ -0,0 +1,159 @@
+#pragma once
+
+// Small benchmark harness shared by the bench/*.cpp suites.
+//
+// Every case is reported as nanoseconds per operation, together with the
+// minimum over the samples, so results from different machines or
+// releases can be compared by a script.
+
+#include "config.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct BenchResult {
+  std::string group;
+  std::string name;
+  std::int64_t iterations = 0; // operations timed in total
+  double median_ns = 0;        // per operation
+  double min_ns = 0;           // per operation
+  // Extra per-operation figures such as node or allocation counts
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+class BenchSuite {
+public:
+  BenchSuite(std::string filter, bool quick)
+      : filter_(std::move(filter)), quick_(quick) {}
+
+  // False when the --filter given on the command line excludes the group.
+  // A filter naming a subgroup, like render/dense/80x24, also enables its
+  // parents so their setup runs.
+  [[nodiscard]] bool enabled(const std::string &group) const {
+    return filter_.empty() || group.find(filter_) != std::string::npos ||
+           filter_.starts_with(group + "/");
+  }
+
+  [[nodiscard]] bool quick() const { return quick_; }
+
+  // Time body() called back to back. The batch size is doubled until one
+  // batch takes long enough to be measured reliably. Returns false if the
+  // group is filtered out.
+  template <typename F>
+  bool run(const std::string &group, const std::string &name, F &&body) {
+    if (!enabled(group)) {
+      return false;
+    }
+    const auto target = quick_ ? std::chrono::milliseconds(2)
+                               : std::chrono::milliseconds(20);
+    std::int64_t batch = 1;
+    while (time_batch(batch, body) < target && batch < (1 << 30)) {
+      batch *= 2;
+    }
+    std::vector<double> samples;
+    for (int i = 0; i < sample_count(); ++i) {
+      samples.push_back(ns(time_batch(batch, body)) / batch);
+    }
+    add(group, name, batch * sample_count(), samples);
+    return true;
+  }
+
+  // Time each call of body() on its own, after an untimed setup(); for
+  // operations that are slow or have to start from a known state
+  template <typename S, typename F>
+  bool run_each(const std::string &group, const std::string &name,
+                S &&setup, F &&body) {
+    if (!enabled(group)) {
+      return false;
+    }
+    std::vector<double> samples;
+    for (int i = 0; i < sample_count(); ++i) {
+      setup();
+      auto start = Clock::now();
+      body();
+      samples.push_back(ns(Clock::now() - start));
+    }
+    add(group, name, sample_count(), samples);
+    return true;
+  }
+
+  // Attach a counter to the case that ran last
+  void annotate(const std::string &key, double value) {
+    if (!results_.empty()) {
+      results_.back().counters.emplace_back(key, value);
+    }
+  }
+
+  [[nodiscard]] const std::vector<BenchResult> &results() const {
+    return results_;
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  int sample_count() const { return quick_ ? 3 : 7; }
+
+  template <typename F> static Clock::duration time_batch(std::int64_t n, F &body) {
+    auto start = Clock::now();
+    for (std::int64_t i = 0; i < n; ++i) {
+      body();
+    }
+    return Clock::now() - start;
+  }
+
+  static double ns(Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count();
+  }
+
+  void add(const std::string &group, const std::string &name,
+           std::int64_t iterations, std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    results_.push_back({group, name, iterations, samples[samples.size() / 2],
+                        samples.front(), {}});
+  }
+
+  std::string filter_;
+  bool quick_;
+  std::vector<BenchResult> results_;
+};
+
+// Keep a value alive so the optimizer cannot drop the work producing it
+template <typename T> inline void do_not_optimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Number of operator new calls so far, counted by bench_main.cpp
+std::uint64_t allocation_count();
+
+// A generated diary directory together with a config that covers it
+struct DiaryTree {
+  std::string name;
+  Config config;
+  // Entries worth previewing, as (label, path)
+  std::vector<std::pair<std::string, std::string>> preview_entries;
+};
+
+// Generate under root the synthetic diary trees that an enabled group
+// of the suite needs
+std::vector<DiaryTree> make_diary_trees(const BenchSuite &suite,
+                                        const std::string &root);
+
+void run_date_benchmarks(BenchSuite &suite);
+// Runs in forked children; call before anything loads the tz database
+void run_startup_benchmarks(BenchSuite &suite,
+                            const std::vector<DiaryTree> &trees);
+void run_diary_benchmarks(BenchSuite &suite,
+                          const std::vector<DiaryTree> &trees);
+// Off-screen terminal size for the render benchmarks
+struct RenderSize {
+  int width = 0;
+  int height = 0;
+};
+
+void run_render_benchmarks(BenchSuite &suite,
+                           const std::vector<DiaryTree> &trees,
+                           const std::vector<RenderSize> &sizes);
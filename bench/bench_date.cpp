@@ -0,0 +1,84 @@
+// Date arithmetic and path formatting on the render path.
+//
+// Compares the closed-form days_from_epoch() in date.hpp against the
+// year-by-year loop it replaced, using the call pattern of one
+// RenderMonthCalendar frame (two conversions per day cell) and of
+// LifeModel::build + refresh over an 80-year life.
+
+#include "bench.hpp"
+#include "date.hpp"
+#include "diary.hpp"
+
+namespace {
+int legacy_days_from_epoch(int y, int m, int d) {
+  int total = 0;
+  for (int i = 1; i < y; ++i) {
+    total += is_leap(i) ? 366 : 365;
+  }
+  for (int i = 1; i < m; ++i) {
+    total += days_in_month(y, i);
+  }
+  total += d;
+  return total;
+}
+
+int closed_form_days(int y, int m, int d) { return days_from_epoch(y, m, d); }
+
+// One month panel: 42 cells, each converting the cell and today
+template <typename DaysFn> int month_frame(DaysFn days, int i) {
+  int y = 2020 + i % 8;
+  int m = 1 + i % 12;
+  int acc = 0;
+  for (int cell = 0; cell < 42; ++cell) {
+    int d = 1 + cell % 28;
+    acc += days(y, m, d) > days(2026, 10, 17);
+  }
+  return acc;
+}
+
+// Model build + refresh: three conversions per month of life
+template <typename DaysFn> int life_model(DaysFn days) {
+  int acc = 0;
+  for (int y = 2000; y < 2080; ++y) {
+    for (int m = 1; m <= 12; ++m) {
+      int n = days_in_month(y, m);
+      acc += days(y, m, 1) + days(y, m, n) + days(y, m, n);
+    }
+  }
+  return acc;
+}
+} // namespace
+
+void run_date_benchmarks(BenchSuite &suite) {
+  int i = 0;
+  suite.run("date", "days_from_epoch", [&] {
+    do_not_optimize(days_from_epoch(1900 + i++ % 200, 6, 15));
+  });
+  suite.run("date", "days_from_epoch_legacy_loop", [&] {
+    do_not_optimize(legacy_days_from_epoch(1900 + i++ % 200, 6, 15));
+  });
+  suite.run("date", "date_from_epoch", [&] {
+    int y = 0, m = 0, d = 0;
+    date_from_epoch(i++ % 40000, y, m, d);
+    do_not_optimize(y + m + d);
+  });
+  suite.run("date", "month_panel_frame", [&] {
+    do_not_optimize(month_frame(closed_form_days, i++));
+  });
+  suite.run("date", "month_panel_frame_legacy_loop", [&] {
+    do_not_optimize(month_frame(legacy_days_from_epoch, i++));
+  });
+  suite.run("date", "life_model_80y", [&] {
+    do_not_optimize(life_model(closed_form_days));
+  });
+  suite.run("date", "life_model_80y_legacy_loop", [&] {
+    do_not_optimize(life_model(legacy_days_from_epoch));
+  });
+
+  const std::string diary_dir = "/home/user/Documents/life";
+  suite.run("path", "get_diary_path", [&] {
+    int n = i++;
+    do_not_optimize(
+        get_diary_path(2000 + n % 80, 1 + n % 12, 1 + n % 28, diary_dir));
+  });
+}
@@ -0,0 +1,224 @@
+// Synthetic diary trees and the filesystem side of a refresh.
+//
+// Trees are written once per run under a temporary directory:
+//   sparse   40 years, an entry every tenth day
+//   dense    40 years, an entry every day
+//   century  100 years, an entry every day
+//   huge     one year of entries plus two very large files
+
+#include "bench.hpp"
+#include "calendar.hpp"
+#include "date.hpp"
+#include "diary.hpp"
+#include "diary_index.hpp"
+#include "diary_template.hpp"
+#include "preview_document.hpp"
+#include "range_query.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr const char *kWords[] = {
+    "today", "walked", "along", "the",   "river", "and",    "thought",
+    "about", "work",   "a",     "long",  "call",  "with",   "family",
+    "read",  "twenty", "pages", "quiet", "rain",  "coffee", "again"};
+
+// Markdown-ish text of roughly the given size, in lines of line_width
+// characters; a line_width of 0 writes it as a single line
+std::string make_text(std::size_t size, std::size_t line_width, int seed) {
+  std::string text = "# Notes\n\n";
+  std::size_t line = 0;
+  for (int w = seed; text.size() < size; ++w) {
+    std::string_view word = kWords[w % std::size(kWords)];
+    text.append(word);
+    line += word.size() + 1;
+    if (line_width != 0 && line >= line_width) {
+      text.push_back('\n');
+      line = 0;
+    } else {
+      text.push_back(' ');
+    }
+  }
+  text.push_back('\n');
+  return text;
+}
+
+// assets/template.md plus every placeholder
+constexpr const char *kTemplate =
+    "# Diary Entry: {date}\n\n{weekday}, week {week}, age {age}, "
+    "{days_left} days left\n\n## What happened today?\n- \n\n"
+    "## Mood / Energy\n- \n\n## Reflection\n- \n";
+
+void write_entry(const std::string &dir, int y, int m, int d,
+                 const std::string &text) {
+  std::ofstream(get_diary_path(y, m, d, dir), std::ios::binary) << text;
+}
+
+// Write an entry for every step-th day of [first_year, last_year]
+void write_years(const std::string &dir, int first_year, int last_year,
+                 int step, std::size_t entry_size) {
+  for (int y = first_year; y <= last_year; ++y) {
+    fs::create_directories(get_diary_year_dir(y, dir));
+  }
+  int first = days_from_epoch(first_year, 1, 1);
+  int last = days_from_epoch(last_year, 12, 31);
+  for (int days = first; days <= last; days += step) {
+    int y = 0, m = 0, d = 0;
+    date_from_epoch(days, y, m, d);
+    write_entry(dir, y, m, d, make_text(entry_size, 60, days));
+  }
+}
+
+DiaryTree make_tree(const std::string &root, const std::string &name,
+                    const std::string &birth, const std::string &death) {
+  DiaryTree tree;
+  tree.name = name;
+  tree.config.birth_date_str = birth;
+  tree.config.death_date_str = death;
+  tree.config.diary_dir = root + "/" + name;
+  tree.config.tick_rate = 0;
+  (void)parse_date(birth, tree.config.birth_year, tree.config.birth_month,
+                   tree.config.birth_day);
+  (void)parse_date(death, tree.config.death_year, tree.config.death_month,
+                   tree.config.death_day);
+  fs::create_directories(tree.config.diary_dir);
+  return tree;
+}
+
+// Make the next refresh rescan one year directory, as after adding or
+// removing an entry outside the app
+void touch_year_dir(const DiaryTree &tree, int year) {
+  std::string probe =
+      get_diary_year_dir(year, tree.config.diary_dir) + "/.bench-touch";
+  std::ofstream{probe};
+  fs::remove(probe);
+}
+} // namespace
+
+std::vector<DiaryTree> make_diary_trees(const BenchSuite &suite,
+                                        const std::string &root) {
+  std::vector<DiaryTree> trees;
+  auto wanted = [&](const std::string &name) {
+    bool any = suite.enabled("startup/" + name) ||
+               suite.enabled("diary/" + name) ||
+               suite.enabled("preview/" + name) ||
+               suite.enabled("render/" + name);
+    if (any) {
+      std::fprintf(stderr, "Generating %s/%s\n", root.c_str(), name.c_str());
+    }
+    return any;
+  };
+
+  if (wanted("sparse")) {
+    auto tree = make_tree(root, "sparse", "1986-01-01", "2066-01-01");
+    const auto &dir = tree.config.diary_dir;
+    write_years(dir, 1986, 2025, 10, 300);
+    tree.preview_entries.push_back(
+        {"typical", get_diary_path(2025, 1, 1, dir)});
+    trees.push_back(tree);
+  }
+
+  if (wanted("dense")) {
+    auto tree = make_tree(root, "dense", "1986-01-01", "2066-01-01");
+    const auto &dir = tree.config.diary_dir;
+    write_years(dir, 1986, 2025, 1, 1500);
+    tree.preview_entries.push_back(
+        {"typical", get_diary_path(2025, 6, 15, dir)});
+    trees.push_back(tree);
+  }
+
+  if (wanted("century")) {
+    auto tree = make_tree(root, "century", "1926-01-01", "2046-01-01");
+    const auto &dir = tree.config.diary_dir;
+    write_years(dir, 1926, 2025, 1, 300);
+    tree.preview_entries.push_back(
+        {"typical", get_diary_path(1970, 6, 15, dir)});
+    trees.push_back(tree);
+  }
+
+  if (wanted("huge")) {
+    std::size_t huge_size = suite.quick() ? (4u << 20) : (64u << 20);
+    auto tree = make_tree(root, "huge", "1990-01-01", "2070-01-01");
+    const auto &dir = tree.config.diary_dir;
+    write_years(dir, 2025, 2025, 1, 1500);
+    write_entry(dir, 2025, 6, 15, make_text(huge_size, 60, 1));
+    write_entry(dir, 2025, 6, 16, make_text(huge_size, 0, 2));
+    tree.preview_entries.push_back(
+        {"huge_lines", get_diary_path(2025, 6, 15, dir)});
+    tree.preview_entries.push_back(
+        {"huge_single_line", get_diary_path(2025, 6, 16, dir)});
+    trees.push_back(tree);
+  }
+
+  return trees;
+}
+
+void run_diary_benchmarks(BenchSuite &suite,
+                          const std::vector<DiaryTree> &trees) {
+  for (const auto &tree : trees) {
+    const std::string group = "diary/" + tree.name;
+    if (suite.enabled(group)) {
+      const std::string index = DiaryIndex::index_path(tree.config.diary_dir);
+      auto handle = MakeLifeCalendarApp(tree.config, nullptr);
+
+      suite.run_each(
+          group, "refresh_cold", [&] { fs::remove(index); },
+          [&] { handle.RefreshDiaryStatus(); });
+      suite.run_each(
+          group, "refresh_warm", [] {}, [&] { handle.RefreshDiaryStatus(); });
+      suite.run_each(
+          group, "refresh_one_year_changed",
+          [&] { touch_year_dir(tree, 2025); },
+          [&] { handle.RefreshDiaryStatus(); });
+
+      // --query over the whole life span, from a warm index to /dev/null
+      const auto &c = tree.config;
+      int from = days_from_epoch(c.birth_year, c.birth_month, c.birth_day);
+      int to = days_from_epoch(c.death_year, c.death_month, c.death_day);
+      if (std::FILE *sink = std::fopen("/dev/null", "w")) {
+        suite.run(group, "query_range_jsonl", [&] {
+          DiaryIndex index;
+          index.load(c.diary_dir);
+          do_not_optimize(write_range_query(index, from, to,
+                                            RangeFormat::JsonLines, sink));
+        });
+        std::fclose(sink);
+      }
+
+      // Template text for a year of new entries, as when backfilling: the
+      // template is compiled once and only stat'ed per entry
+      std::string template_path = c.diary_dir + "/.bench-template.md";
+      std::ofstream(template_path) << kTemplate;
+      DiaryTemplate entry_template(template_path, from, to);
+      std::string text;
+      int year_start = days_from_epoch(2025, 1, 1);
+      suite.run(group, "template_backfill_year", [&] {
+        for (int days = year_start; days < year_start + 365; ++days) {
+          int y = 0, m = 0, d = 0;
+          date_from_epoch(days, y, m, d);
+          entry_template.refresh();
+          entry_template.expand(y, m, d, text);
+          do_not_optimize(text.size());
+        }
+      });
+    }
+
+    for (const auto &[label, path] : tree.preview_entries) {
+      suite.run("preview/" + tree.name, "preview_diary_lines_" + label,
+                [&] { do_not_optimize(preview_diary_lines(path, 100)); });
+      // What the preview pane does: open, then fit one screen of lines
+      suite.run("preview/" + tree.name, "preview_first_screen_" + label, [&] {
+        PreviewDocument document;
+        document.open(path);
+        std::string_view line;
+        for (std::size_t i = 0; i < 50 && document.line(i, line); ++i) {
+          do_not_optimize(fit_to_width(line, 80));
+        }
+      });
+    }
+  }
+}
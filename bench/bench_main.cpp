@@ -0,0 +1,166 @@
+// life-calendar-bench: runs every suite and prints one line per case, or
+// a JSON document with --json for comparing releases.
+//
+// Usage: life-calendar-bench [--json] [--quick] [--filter GROUP]
+//                            [--sizes WxH,...] [--keep]
+
+#include "bench.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <string_view>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// Count every allocation of the process. The array and nothrow forms
+// forward to these, so replacing the plain and aligned ones is enough.
+namespace {
+std::atomic<std::uint64_t> g_allocations{0};
+} // namespace
+
+std::uint64_t allocation_count() {
+  return g_allocations.load(std::memory_order_relaxed);
+}
+
+void *operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  auto alignment = static_cast<std::size_t>(align);
+  size = (size + alignment - 1) / alignment * alignment;
+  if (void *p = std::aligned_alloc(alignment, size ? size : alignment)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+// Parse "80x24,400x120" into sizes
+bool parse_sizes(std::string_view text, std::vector<RenderSize> &out) {
+  out.clear();
+  while (!text.empty()) {
+    auto comma = text.find(',');
+    auto item = text.substr(0, comma);
+    RenderSize size;
+    if (std::sscanf(std::string(item).c_str(), "%dx%d", &size.width,
+                    &size.height) != 2 ||
+        size.width <= 0 || size.height <= 0) {
+      return false;
+    }
+    out.push_back(size);
+    text = comma == std::string_view::npos ? "" : text.substr(comma + 1);
+  }
+  return !out.empty();
+}
+
+std::string json_string(std::string_view s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+    }
+    out.push_back(c);
+  }
+  out.push_back('"');
+  return out;
+}
+
+void print_table(const std::vector<BenchResult> &results) {
+  std::printf("%-20s %-38s %14s %14s\n", "group", "case", "median",
+              "min");
+  for (const auto &r : results) {
+    std::printf("%-20s %-38s %11.1f ns %11.1f ns", r.group.c_str(),
+                r.name.c_str(), r.median_ns, r.min_ns);
+    for (const auto &[key, value] : r.counters) {
+      std::printf("  %s=%.0f", key.c_str(), value);
+    }
+    std::printf("\n");
+  }
+}
+
+void print_json(const std::vector<BenchResult> &results, bool quick) {
+  std::printf("{\n  \"suite\": \"life-calendar-bench\",\n");
+  std::printf("  \"quick\": %s,\n  \"results\": [\n", quick ? "true" : "false");
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const auto &r = results[i];
+    std::printf("    {\"group\": %s, \"name\": %s, \"iterations\": %lld, "
+                "\"median_ns\": %.1f, \"min_ns\": %.1f",
+                json_string(r.group).c_str(), json_string(r.name).c_str(),
+                static_cast<long long>(r.iterations), r.median_ns, r.min_ns);
+    for (const auto &[key, value] : r.counters) {
+      std::printf(", %s: %.0f", json_string(key).c_str(), value);
+    }
+    std::printf("}%s\n", i + 1 < results.size() ? "," : "");
+  }
+  std::printf("  ]\n}\n");
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  bool json = false;
+  bool quick = false;
+  bool keep = false;
+  std::string filter;
+  std::vector<RenderSize> sizes = {
+      {80, 24}, {120, 40}, {200, 60}, {400, 120}, {800, 240}};
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--json") == 0) {
+      json = true;
+    } else if (std::strcmp(argv[i], "--quick") == 0) {
+      quick = true;
+    } else if (std::strcmp(argv[i], "--keep") == 0) {
+      keep = true;
+    } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (std::strcmp(argv[i], "--sizes") == 0 && i + 1 < argc &&
+               parse_sizes(argv[i + 1], sizes)) {
+      ++i;
+    } else {
+      std::fprintf(stderr,
+                   "Usage: %s [--json] [--quick] [--filter GROUP] "
+                   "[--sizes WxH,...] [--keep]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  BenchSuite suite(filter, quick);
+  run_date_benchmarks(suite);
+
+  std::string root = (fs::temp_directory_path() /
+                      ("life-calendar-bench-" + std::to_string(getpid())))
+                         .string();
+  auto trees = make_diary_trees(suite, root);
+  run_startup_benchmarks(suite, trees);
+  run_diary_benchmarks(suite, trees);
+  run_render_benchmarks(suite, trees, sizes);
+  if (!keep) {
+    std::error_code ec;
+    fs::remove_all(root, ec);
+  }
+
+  if (json) {
+    print_json(suite.results(), quick);
+  } else {
+    print_table(suite.results());
+  }
+  return 0;
+}
@@ -0,0 +1,111 @@
+// Frames of the calendar component rendered into an off-screen
+// ftxui::Screen at several terminal sizes.
+//
+// Whole frames are measured with the element caches warm and after
+// navigating; each section is also built from scratch on its own. Every
+// case reports the node count of the element tree and the allocations
+// made per frame.
+
+#include "bench.hpp"
+#include "calendar.hpp"
+
+#include <ftxui/component/event.hpp>
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/screen.hpp>
+
+using namespace ftxui;
+
+namespace {
+// Node keeps its children protected; a member pointer formed through a
+// derived class reads them without touching ftxui
+struct NodeChildren : Node {
+  static constexpr Elements Node::*member = &NodeChildren::children_;
+};
+
+std::size_t count_nodes(const Element &element) {
+  if (!element) {
+    return 0;
+  }
+  std::size_t count = 1;
+  for (const auto &child : (*element).*NodeChildren::member) {
+    count += count_nodes(child);
+  }
+  return count;
+}
+
+// Time build() plus drawing its result, then record the node count and
+// the allocations of one more frame
+template <typename F>
+void measure_frame(BenchSuite &suite, const std::string &group,
+                   const std::string &name, Screen &screen, F &&build) {
+  if (!suite.run(group, name, [&] { Render(screen, build()); })) {
+    return;
+  }
+  auto before = allocation_count();
+  auto element = build();
+  Render(screen, element);
+  auto allocations = allocation_count() - before;
+  suite.annotate("nodes", static_cast<double>(count_nodes(element)));
+  suite.annotate("allocs", static_cast<double>(allocations));
+}
+} // namespace
+
+void run_render_benchmarks(BenchSuite &suite,
+                           const std::vector<DiaryTree> &trees,
+                           const std::vector<RenderSize> &sizes) {
+  for (const auto &tree : trees) {
+    const std::string prefix = "render/" + tree.name;
+    if (!suite.enabled(prefix)) {
+      continue;
+    }
+
+    auto handle = MakeLifeCalendarApp(tree.config, nullptr);
+    for (const auto &size : sizes) {
+      const std::string group = prefix + "/" + std::to_string(size.width) +
+                                "x" + std::to_string(size.height);
+      if (!suite.enabled(group)) {
+        continue;
+      }
+      handle.SetSizeSource(
+          [size] { return Dimensions{size.width, size.height}; });
+      auto screen = Screen::Create(Dimension::Fixed(size.width),
+                                   Dimension::Fixed(size.height));
+
+      measure_frame(suite, group, "frame_cached", screen,
+                    [&] { return handle.component->Render(); });
+
+      // Moving the focus invalidates both cached panels
+      bool forward = true;
+      measure_frame(suite, group, "frame_navigate", screen, [&] {
+        handle.component->OnEvent(forward ? Event::ArrowRight
+                                          : Event::ArrowLeft);
+        forward = !forward;
+        return handle.component->Render();
+      });
+
+      // The same in the bytes heatmap ('v' twice), which sums every cell
+      handle.component->OnEvent(Event::Character('v'));
+      handle.component->OnEvent(Event::Character('v'));
+      measure_frame(suite, group, "frame_navigate_heatmap", screen, [&] {
+        handle.component->OnEvent(forward ? Event::ArrowRight
+                                          : Event::ArrowLeft);
+        forward = !forward;
+        return handle.component->Render();
+      });
+      handle.component->OnEvent(Event::Character('v'));
+
+      measure_frame(suite, group, "section_life", screen, [&] {
+        return handle.RenderSection(CalendarSection::Life);
+      });
+      measure_frame(suite, group, "section_month", screen, [&] {
+        return handle.RenderSection(CalendarSection::Month);
+      });
+      measure_frame(suite, group, "section_countdown", screen, [&] {
+        return handle.RenderSection(CalendarSection::Countdown);
+      });
+      measure_frame(suite, group, "section_stats", screen, [&] {
+        return handle.RenderSection(CalendarSection::Stats);
+      });
+    }
+  }
+}
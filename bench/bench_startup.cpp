@@ -0,0 +1,64 @@
+// Startup of the one-shot CLI modes, measured end to end.
+//
+// Every case forks a child that does what main() does for --check-today
+// and exits, so process-wide caches such as the tz database start out
+// empty, as in a fresh process. Must run before any other suite takes a
+// clock snapshot, or the children would inherit a loaded tz database.
+// fork_only is the floor the other cases are measured against.
+
+#include "bench.hpp"
+#include "clock.hpp"
+#include "config.hpp"
+#include "date.hpp"
+#include "diary.hpp"
+
+#include <cstdlib>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+template <typename F> void run_in_child(F &&body) {
+  pid_t pid = fork();
+  if (pid == 0) {
+    body();
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+}
+
+// --check-today, given how today is worked out
+template <typename Today> void check_today(Today today) {
+  Config config = load_config();
+  int y = 0, m = 0, d = 0;
+  date_from_epoch(today(), y, m, d);
+  do_not_optimize(diary_exists(y, m, d, config.diary_dir));
+}
+} // namespace
+
+void run_startup_benchmarks(BenchSuite &suite,
+                            const std::vector<DiaryTree> &trees) {
+  for (const auto &tree : trees) {
+    const std::string group = "startup/" + tree.name;
+    if (!suite.enabled(group)) {
+      continue;
+    }
+    // load_config() reads these; the template must never be created
+    setenv("LIFE_CALENDAR_DIARY_DIR", tree.config.diary_dir.c_str(), 1);
+    setenv("LIFE_CALENDAR_DIARY_TEMPLATE",
+           (tree.config.diary_dir + "/.bench-no-template.md").c_str(), 1);
+
+    suite.run_each(group, "fork_only", [] {}, [] { run_in_child([] {}); });
+    suite.run_each(
+        group, "check_today", [] {},
+        [] { run_in_child([] { check_today(local_today_days); }); });
+    // What --check-today cost when it went through the tz database
+    suite.run_each(
+        group, "check_today_tzdb", [] {}, [] {
+          run_in_child([] {
+            check_today([] { return take_clock_snapshot().days; });
+          });
+        });
+  }
+}
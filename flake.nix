@@ -66,6 +66,22 @@
       nixosModules.default = { config, lib, pkgs, ... }:
         let
           cfg = config.programs.life-calendar;
+          package = pkgs.symlinkJoin {
+            name = "life-calendar-configured";
+            paths = [ self.packages.${pkgs.system}.default ];
+            nativeBuildInputs = [ pkgs.makeWrapper ];
+            postBuild = ''
+              wrapProgram $out/bin/life-calendar \
+                --set LIFE_CALENDAR_BIRTH_DATE "${cfg.birthDate}" \
+                --set LIFE_CALENDAR_DEATH_DATE "${cfg.deathDate}" \
+                --set LIFE_CALENDAR_EDITOR "${cfg.editor}" \
+                --set LIFE_CALENDAR_REMOTE_EDITOR "${cfg.remoteEditor}" \
+                --set LIFE_CALENDAR_DIARY_DIR "${cfg.diaryDir}" \
+                --set LIFE_CALENDAR_DIARY_TEMPLATE "${cfg.diaryTemplate}" \
+                --set LIFE_CALENDAR_TICK_RATE "${toString cfg.tickRate}" \
+                --set LIFE_CALENDAR_DIARY_TEMPLATE_FALLBACK "${self.packages.${pkgs.system}.default}/share/life-calendar/template.md"
+            '';
+          };
         in
         {
           options.programs.life-calendar = {
@@ -85,6 +101,11 @@
               default = "vi";
               description = "The editor to use for diary entries.";
             };
+            remoteEditor = lib.mkOption {
+              type = lib.types.str;
+              default = "";
+              description = "Command handing diary entries to a running editor server, e.g. `nvim --server /tmp/nvim.sock --remote`; empty to always suspend the TUI for `editor`.";
+            };
             diaryDir = lib.mkOption {
               type = lib.types.str;
               default = "~/.life-calendar/diary";
@@ -95,25 +116,25 @@
               default = "~/.life-calendar/template.md";
               description = "Path to a template file for new diary entries.";
             };
+            tickRate = lib.mkOption {
+              type = lib.types.ints.between 0 1000;
+              default = 1;
+              description = "Countdown updates per second; 0 disables the live countdown.";
+            };
+            daemon.enable = lib.mkEnableOption "a user service answering `life-calendar --client` queries";
           };
 
           config = lib.mkIf cfg.enable {
-            environment.systemPackages = [
-              (pkgs.symlinkJoin {
-                name = "life-calendar-configured";
-                paths = [ self.packages.${pkgs.system}.default ];
-                nativeBuildInputs = [ pkgs.makeWrapper ];
-                postBuild = ''
-                  wrapProgram $out/bin/life-calendar \
-                    --set LIFE_CALENDAR_BIRTH_DATE "${cfg.birthDate}" \
-                    --set LIFE_CALENDAR_DEATH_DATE "${cfg.deathDate}" \
-                    --set LIFE_CALENDAR_EDITOR "${cfg.editor}" \
-                    --set LIFE_CALENDAR_DIARY_DIR "${cfg.diaryDir}" \
-                    --set LIFE_CALENDAR_DIARY_TEMPLATE "${cfg.diaryTemplate}" \
-                    --set LIFE_CALENDAR_DIARY_TEMPLATE_FALLBACK "${self.packages.${pkgs.system}.default}/share/life-calendar/template.md"
-                '';
-              })
-            ];
+            environment.systemPackages = [ package ];
+
+            systemd.user.services.life-calendar-daemon = lib.mkIf cfg.daemon.enable {
+              description = "Life Calendar diary query daemon";
+              wantedBy = [ "default.target" ];
+              serviceConfig = {
+                ExecStart = "${package}/bin/life-calendar --daemon";
+                Restart = "on-failure";
+              };
+            };
           };
         };
 
@@ -1,33 +1,35 @@
 #include "calendar.hpp"
+#include "clock.hpp"
 #include "config.hpp"
+#include "date.hpp"
 #include "diary.hpp"
+#include "io_worker.hpp"
+#include "life_model.hpp"
+#include "preview_cache.hpp"
+#include "preview_document.hpp"
+#include "profile.hpp"
+#include "search_index.hpp"
 
 #include <ftxui/component/component.hpp>
 #include <ftxui/component/event.hpp>
 #include <ftxui/dom/elements.hpp>
+#include <ftxui/dom/node.hpp>
 #include <ftxui/screen/color.hpp>
 #include <ftxui/screen/terminal.hpp>
 
 #include <algorithm>
 #include <chrono>
-#include <fstream>
+#include <cmath>
 #include <iomanip>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 using namespace ftxui;
 
 namespace {
-struct MonthInfo {
-  int year = 0;
-  int month = 0;
-  bool is_past = false;
-  bool is_current = false;
-  bool is_future = false;
-  bool has_full_diary = false;
-};
-
 struct LayoutInfo {
   int width = 0;
   int height = 0;
@@ -44,6 +46,7 @@ struct LayoutInfo {
 
   int right_top_h = 0;
   int right_bottom_h = 0;
+  int right_stats_h = 0; // 0 when the terminal is too short for it
 
   int left_grid_x = 0;
   int left_grid_y = 0;
@@ -58,29 +61,56 @@ struct LayoutInfo {
   int month_grid_y = 0;
 };
 
-static bool is_leap(int y) {
-  return (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0);
-}
+// Lays its child out unchanged and ends the profiled frame once the child
+// has been drawn, so frame times include ftxui's layout and draw passes
+class FrameEndNode : public Node {
+public:
+  explicit FrameEndNode(Element child) : Node({std::move(child)}) {}
 
-static int days_in_month(int y, int m) {
-  static const int dm[] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-  if (m == 2 && is_leap(y)) {
-    return 29;
+  void ComputeRequirement() override {
+    Node::ComputeRequirement();
+    requirement_ = children_[0]->requirement();
   }
-  return dm[m];
+
+  void SetBox(Box box) override {
+    Node::SetBox(box);
+    children_[0]->SetBox(box);
+  }
+
+  void Render(Screen &screen) override {
+    Node::Render(screen);
+    profile::frame_end();
+  }
+};
+
+static std::string format_ms(double ms) {
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(ms < 10 ? 2 : 0) << ms << "ms";
+  return oss.str();
 }
 
-static int weekday_index(int y, int m, int d) {
-  using namespace std::chrono;
-  auto sys_day = sys_days{year{y} / month{static_cast<unsigned>(m)} /
-                          day{static_cast<unsigned>(d)}};
-  return int(weekday{sys_day}.c_encoding()); // 0=Sun
+static std::string format_bytes(std::uint64_t bytes) {
+  std::ostringstream oss;
+  if (bytes < 10 * 1024) {
+    oss << bytes << "B";
+  } else if (bytes < 10 * 1024 * 1024) {
+    oss << bytes / 1024 << "KB";
+  } else {
+    oss << bytes / (1024 * 1024) << "MB";
+  }
+  return oss.str();
 }
 
-static std::string format_date(int y, int m, int d) {
+// 1234 -> 1234, 12345 -> 12k, 1234567 -> 1.2M
+static std::string format_count(std::int64_t count) {
   std::ostringstream oss;
-  oss << y << "-" << std::setfill('0') << std::setw(2) << m << "-"
-      << std::setfill('0') << std::setw(2) << d;
+  if (count < 10000) {
+    oss << count;
+  } else if (count < 1000000) {
+    oss << count / 1000 << "k";
+  } else {
+    oss << std::fixed << std::setprecision(1) << count / 1e6 << "M";
+  }
   return oss.str();
 }
 
@@ -92,23 +122,6 @@ static std::string month_name(int m) {
   }
   return names[m];
 }
-
-static std::vector<std::string> preview_diary_lines(const std::string &path,
-                                                    int max_lines) {
-  std::vector<std::string> lines;
-  std::ifstream ifs(path);
-  if (!ifs) {
-    return lines;
-  }
-  std::string line;
-  while (max_lines-- > 0 && std::getline(ifs, line)) {
-    if (line.size() > 64) {
-      line = line.substr(0, 61) + "...";
-    }
-    lines.push_back(line);
-  }
-  return lines;
-}
 } // namespace
 
 class CalendarGridBase : public ComponentBase {
@@ -116,41 +129,83 @@ public:
   CalendarGridBase(
       const Config &config,
       std::function<void(int year, int month, int day)> on_select_day)
-      : config_(config), on_select_day_(std::move(on_select_day)) {
+      : config_(config), model_(config),
+        on_select_day_(std::move(on_select_day)),
+        search_index_(std::make_shared<SearchIndex>()) {
     BuildMonths();
-    RefreshDiaryStatus();
+    legend_ = RenderLegend();
+    heat_legend_ = RenderHeatLegend();
+    weekday_header_ = RenderWeekdayHeader();
   }
 
   Element OnRender() override {
+    profile::frame_begin();
+    if (!diary_requested_) {
+      RefreshDiaryStatus();
+    }
     UpdateLayout();
+    UpdateCountdownVisibility();
+    auto clock = take_clock_snapshot();
 
     auto left =
-        HighlightPanel(RenderLifeCalendar(), active_panel_ == Panel::Life);
+        HighlightPanel(CachedLifeCalendar(), active_panel_ == Panel::Life);
     auto right_top =
-        HighlightPanel(RenderMonthCalendar(), active_panel_ == Panel::Month);
-    auto right_bottom = RenderCountdown();
+        search_active_
+            ? HighlightPanel(RenderSearch(), true)
+            : HighlightPanel(CachedMonthCalendar(clock),
+                             active_panel_ == Panel::Month);
+    auto right_bottom = RenderCountdown(clock);
 
-    auto right = vbox({
+    Elements right_panels = {
         right_top | size(HEIGHT, EQUAL, layout_.right_top_h),
         right_bottom | size(HEIGHT, EQUAL, layout_.right_bottom_h),
-    });
+    };
+    if (layout_.right_stats_h > 0) {
+      right_panels.push_back(RenderStats(clock) |
+                             size(HEIGHT, EQUAL, layout_.right_stats_h));
+    }
+    auto right = vbox(std::move(right_panels));
 
-    return hbox({
+    auto frame = hbox({
         left | size(WIDTH, EQUAL, layout_.left_w),
         right | size(WIDTH, EQUAL, layout_.right_w),
     });
+    if (profile::enabled()) {
+      return std::make_shared<FrameEndNode>(std::move(frame));
+    }
+    return frame;
   }
 
   bool OnEvent(Event event) override {
-    UpdateLayout();
-
+    // Ticks and I/O results arrive as Custom; only input is timed to the
+    // frame that shows it
     if (event == Event::Custom) {
       return true;
     }
+    profile::mark_event();
+    UpdateLayout();
+
+    auto clock = take_clock_snapshot();
 
     if (event.is_mouse()) {
       auto &mouse = event.mouse();
-      HandleMouse(mouse);
+      HandleMouse(mouse, clock);
+      return true;
+    }
+
+    if (search_active_) {
+      return HandleSearchKeys(event, clock);
+    }
+
+    if (event == Event::Character('/')) {
+      search_active_ = true;
+      return true;
+    }
+
+    if (event == Event::Character('v')) {
+      heatmap_ = heatmap_ == Heatmap::Off       ? Heatmap::Entries
+                 : heatmap_ == Heatmap::Entries ? Heatmap::Bytes
+                                                : Heatmap::Off;
       return true;
     }
 
@@ -160,37 +215,201 @@ public:
       return true;
     }
 
+    if (HandlePreviewKeys(event)) {
+      return true;
+    }
+
     if (active_panel_ == Panel::Life) {
-      return HandleLifeKeys(event);
+      return HandleLifeKeys(event, clock);
     }
-    return HandleMonthKeys(event);
+    return HandleMonthKeys(event, clock);
   }
 
   bool Focusable() const override { return true; }
 
+  // True while keys are typed into the search box
+  bool CapturesInput() const { return search_active_; }
+
   void RefreshDiaryStatus() {
-    int today_days = TodayDays();
-    for (auto &m : months_) {
-      int num_days = days_in_month(m.year, m.month);
-      int month_end = days_from_epoch(m.year, m.month, num_days);
-      if (month_end > today_days) {
-        m.has_full_diary = false;
-        continue;
+    diary_requested_ = true;
+    diary_loading_ = true;
+    diary_scanned_ = 0;
+    diary_to_scan_ = 0;
+    preview_cache_.invalidate_all();
+    search_index_stale_ = true;
+    int today_days = take_clock_snapshot().days;
+    // Off the UI thread, show years as they are scanned, newest first
+    bool progressive = io_worker_ != nullptr;
+    UpdateModel(
+        [today_days, progressive](LifeModel &model, const Publish &publish) {
+          profile::ScopedTimer timer(profile::Timer::RefreshDiaryStatus);
+          // Each publish copies the model, so on a fast disk most batches
+          // go by unseen; the last one is always shown, as the statistics
+          // may take a while longer
+          auto last = std::chrono::steady_clock::time_point{};
+          DiaryIndex::Progress progress;
+          if (progressive) {
+            progress = [&](std::size_t done, std::size_t total) {
+              auto now = std::chrono::steady_clock::now();
+              if (done < total && now - last < kProgressInterval) {
+                return;
+              }
+              last = now;
+              publish([done, total](CalendarGridBase &self) {
+                self.diary_scanned_ = done;
+                self.diary_to_scan_ = total;
+              });
+            };
+          }
+          model.refresh_diary_status(today_days, progress);
+        },
+        [](CalendarGridBase &self) { self.diary_loading_ = false; });
+  }
+
+  void RefreshDay(int year, int month, int day) {
+    preview_cache_.invalidate(
+        get_diary_path(year, month, day, config_.diary_dir));
+    search_index_stale_ = true;
+    int today_days = take_clock_snapshot().days;
+    UpdateModel([=](LifeModel &model, const Publish &) {
+      model.refresh_day(year, month, day, today_days);
+    });
+  }
+
+  void ApplyDiaryChanges(const std::vector<DiaryChange> &changes) {
+    for (const auto &change : changes) {
+      if (change.kind == DiaryChange::Kind::Entry) {
+        preview_cache_.invalidate(get_diary_path(
+            change.year, change.month, change.day, config_.diary_dir));
+      } else {
+        preview_cache_.invalidate_all();
       }
-      bool all_days = true;
-      for (int d = 1; d <= num_days; ++d) {
-        if (!diary_exists(m.year, m.month, d, config_.diary_dir)) {
-          all_days = false;
-          break;
-        }
+    }
+    search_index_stale_ = true;
+    int today_days = take_clock_snapshot().days;
+    // Single entries are saved at exit; a rescanned year is saved right
+    // away, so a crash does not leave the next start to rescan it again
+    bool rescan = std::ranges::any_of(changes, [](const DiaryChange &c) {
+      return c.kind != DiaryChange::Kind::Entry;
+    });
+    UpdateModel([changes, today_days, rescan](LifeModel &model,
+                                              const Publish &) {
+      model.apply_changes(changes, today_days);
+      if (rescan) {
+        model.save();
       }
-      m.has_full_diary = all_days;
+    });
+  }
+
+  // Save the index and statistics of the model as last shown; updates
+  // still running on the worker are not waited for
+  void SaveModel() { model_.save(); }
+
+  void SetStatusMessage(std::string message) {
+    status_message_ = std::move(message);
+  }
+
+  // Move diary, preview and search I/O to a background thread. post runs
+  // on that thread and must hand the closure it gets to the UI thread.
+  void SetIoPoster(IoWorker::Deliver post) {
+    io_model_ = std::make_shared<LifeModel>(model_);
+    io_worker_ = std::make_unique<IoWorker>(std::move(post));
+  }
+
+  void SetCountdownVisibilityCallback(std::function<void(bool visible)> cb) {
+    on_countdown_visibility_ = std::move(cb);
+    countdown_visible_.reset();
+  }
+
+  void SetSizeSource(std::function<Dimensions()> source) {
+    size_source_ = std::move(source);
+  }
+
+  Element RenderSection(CalendarSection section) {
+    if (!diary_requested_) {
+      RefreshDiaryStatus();
+    }
+    UpdateLayout();
+    auto clock = take_clock_snapshot();
+    switch (section) {
+    case CalendarSection::Life:
+      return RenderLifeCalendar(RenderLifeGrid());
+    case CalendarSection::Month:
+      return RenderMonthCalendar(clock);
+    case CalendarSection::Countdown:
+      return RenderCountdown(clock);
+    case CalendarSection::Stats:
+      return RenderStats(clock);
     }
+    return text("");
   }
 
 private:
   enum class Panel { Life, Month };
 
+  // What the life grid is coloured by: past/full/current/future, or how
+  // much was written in each cell
+  enum class Heatmap { Off, Entries, Bytes };
+
+  // Everything the life grid is drawn from. The element tree is kept
+  // between frames and rebuilt only when one of these changes; ftxui
+  // recomputes layout on every frame, so reusing the nodes is safe. The
+  // status lines below the grid are cheap and built every frame.
+  struct LifePanelKey {
+    int rows = 0;
+    int cols = 0;
+    int months_per_cell = 0;
+    int focused_month = -1;
+    Panel panel = Panel::Life;
+    Heatmap heatmap = Heatmap::Off;
+    unsigned model_generation = 0;
+
+    bool operator==(const LifePanelKey &) const = default;
+  };
+
+  struct MonthPanelKey {
+    int focused_month = -1;
+    int selected_day = 0;
+    std::size_t preview_scroll = 0;
+    int width = 0;
+    int height = 0;
+    int today_days = 0;
+    Panel panel = Panel::Life;
+    unsigned model_generation = 0;
+    unsigned preview_generation = 0;
+
+    bool operator==(const MonthPanelKey &) const = default;
+  };
+
+  Element CachedLifeCalendar() {
+    LifePanelKey key{layout_.left_rows,
+                     layout_.left_cols,
+                     layout_.left_months_per_cell,
+                     focused_month_,
+                     active_panel_,
+                     heatmap_,
+                     model_generation_};
+    if (!life_grid_ || key != life_grid_key_) {
+      life_grid_ = RenderLifeGrid();
+      life_grid_key_ = key;
+    }
+    return RenderLifeCalendar(life_grid_);
+  }
+
+  Element CachedMonthCalendar(const ClockSnapshot &clock) {
+    SyncPreviewScroll();
+    MonthPanelKey key{focused_month_,     selected_day_,
+                      preview_scroll_,    layout_.right_w,
+                      layout_.right_top_h, clock.days,
+                      active_panel_,      model_generation_,
+                      preview_generation_};
+    if (!month_panel_ || key != month_panel_key_) {
+      month_panel_ = RenderMonthCalendar(clock);
+      month_panel_key_ = key;
+    }
+    return month_panel_;
+  }
+
   Element HighlightPanel(Element panel, bool active) {
     if (!active) {
       return panel;
@@ -199,121 +418,76 @@ private:
   }
 
   void BuildMonths() {
-    months_.clear();
-
-    int today_y = 0, today_m = 0, today_d = 0;
-    get_today(today_y, today_m, today_d);
-    int today_days = days_from_epoch(today_y, today_m, today_d);
-
-    int y = config_.birth_year;
-    int m = config_.birth_month;
-    while (y < config_.death_year ||
-           (y == config_.death_year && m <= config_.death_month)) {
-      MonthInfo info;
-      info.year = y;
-      info.month = m;
-
-      int num_days = days_in_month(y, m);
-      int start_days = days_from_epoch(y, m, 1);
-      int end_days = days_from_epoch(y, m, num_days);
-
-      info.is_past = end_days < today_days;
-      info.is_current = start_days <= today_days && today_days <= end_days;
-      info.is_future = start_days > today_days;
-      info.has_full_diary = false;
-
-      months_.push_back(info);
-
-      ++m;
-      if (m > 12) {
-        m = 1;
-        ++y;
-      }
-    }
-
-    focused_month_ = 0;
-    for (std::size_t i = 0; i < months_.size(); ++i) {
-      if (months_[i].is_current) {
-        focused_month_ = static_cast<int>(i);
-        break;
-      }
-    }
-
-    int ty = 0, tm = 0, td = 0;
-    get_today(ty, tm, td);
-    selected_day_ = td;
+    auto clock = take_clock_snapshot();
+    model_.build(clock.days);
+    focused_month_ = model_.current_month_index();
+    selected_day_ = clock.day;
     ClampSelectedDay();
   }
 
-  int TodayDays() const {
-    int y = 0, m = 0, d = 0;
-    get_today(y, m, d);
-    return days_from_epoch(y, m, d);
-  }
-
   void ClampSelectedDay() {
-    const auto &m = months_[focused_month_];
+    const auto m = model_.month(focused_month_);
     int num_days = days_in_month(m.year, m.month);
     selected_day_ = std::clamp(selected_day_, 1, num_days);
   }
 
-  void SetFocusedMonth(int idx) {
-    if (months_.empty()) {
+  void SetFocusedMonth(int idx, const ClockSnapshot &clock) {
+    if (model_.month_count() == 0) {
       return;
     }
-    idx = std::clamp(idx, 0, static_cast<int>(months_.size() - 1));
+    idx = std::clamp(idx, 0, model_.month_count() - 1);
     if (idx == focused_month_) {
       return;
     }
     focused_month_ = idx;
 
-    int ty = 0, tm = 0, td = 0;
-    get_today(ty, tm, td);
-    const auto &m = months_[focused_month_];
-    if (m.year == ty && m.month == tm) {
-      selected_day_ = td;
+    const auto m = model_.month(focused_month_);
+    if (m.year == clock.year && m.month == clock.month) {
+      selected_day_ = clock.day;
     }
     ClampSelectedDay();
   }
 
-  void MoveMonth(int delta) { SetFocusedMonth(focused_month_ + delta); }
+  void MoveMonth(int delta, const ClockSnapshot &clock) {
+    SetFocusedMonth(focused_month_ + delta, clock);
+  }
 
-  bool HandleLifeKeys(const Event &event) {
+  bool HandleLifeKeys(const Event &event, const ClockSnapshot &clock) {
     if (layout_.left_cols <= 0) {
       return false;
     }
     if (event == Event::ArrowLeft || event == Event::Character('h')) {
-      MoveMonth(-1);
+      MoveMonth(-1, clock);
       return true;
     }
     if (event == Event::ArrowRight || event == Event::Character('l')) {
-      MoveMonth(1);
+      MoveMonth(1, clock);
       return true;
     }
     if (event == Event::ArrowUp || event == Event::Character('k')) {
-      MoveMonth(-layout_.left_cols);
+      MoveMonth(-layout_.left_cols, clock);
       return true;
     }
     if (event == Event::ArrowDown || event == Event::Character('j')) {
-      MoveMonth(layout_.left_cols);
+      MoveMonth(layout_.left_cols, clock);
       return true;
     }
     if (event == Event::Home) {
-      SetFocusedMonth(0);
+      SetFocusedMonth(0, clock);
       return true;
     }
     if (event == Event::End) {
-      SetFocusedMonth(static_cast<int>(months_.size() - 1));
+      SetFocusedMonth(model_.month_count() - 1, clock);
       return true;
     }
     if (event == Event::Return) {
-      ActivateSelectedDay();
+      ActivateSelectedDay(clock);
       return true;
     }
     return false;
   }
 
-  bool HandleMonthKeys(const Event &event) {
+  bool HandleMonthKeys(const Event &event, const ClockSnapshot &clock) {
     if (event == Event::ArrowLeft || event == Event::Character('h')) {
       selected_day_ = std::max(1, selected_day_ - 1);
       return true;
@@ -338,26 +512,253 @@ private:
     }
     if (event == Event::End) {
       ClampSelectedDay();
-      selected_day_ = days_in_month(months_[focused_month_].year,
-                                    months_[focused_month_].month);
+      const auto m = model_.month(focused_month_);
+      selected_day_ = days_in_month(m.year, m.month);
       return true;
     }
     if (event == Event::Return) {
-      ActivateSelectedDay();
+      ActivateSelectedDay(clock);
       return true;
     }
     return false;
   }
 
-  void ActivateSelectedDay() {
-    if (months_.empty()) {
+  // Run update on the model: right here without an I/O worker, otherwise
+  // on the worker's own copy, which is then copied back and swapped in on
+  // the UI thread together with done. Jobs and their results keep their
+  // order, so the model never goes back in time. A long update can call
+  // publish to show the model as it is so far, the same way.
+  using Publish =
+      std::function<void(std::function<void(CalendarGridBase &)> then)>;
+
+  void UpdateModel(std::function<void(LifeModel &, const Publish &)> update,
+                   std::function<void(CalendarGridBase &)> done = {}) {
+    if (!io_worker_) {
+      Publish publish = [this](std::function<void(CalendarGridBase &)> then) {
+        ++model_generation_;
+        if (then) {
+          then(*this);
+        }
+      };
+      update(model_, publish);
+      publish(done);
+      return;
+    }
+    io_worker_->submit([self = this, model = io_model_,
+                        post = io_worker_->partial(), update, done] {
+      auto swap_in = [self,
+                      model](std::function<void(CalendarGridBase &)> then) {
+        auto snapshot = std::make_shared<LifeModel>(*model);
+        return std::function<void()>([self, snapshot, then] {
+          self->model_ = std::move(*snapshot);
+          ++self->model_generation_;
+          if (then) {
+            then(*self);
+          }
+        });
+      };
+      update(*model, [&](std::function<void(CalendarGridBase &)> then) {
+        post(swap_in(std::move(then)));
+      });
+      return swap_in(done);
+    });
+  }
+
+  // The selected day's note. With an I/O worker it is opened there and
+  // indexed as far as one line past the first screen, and this is nullptr
+  // until it arrives; a stale note is shown until its replacement is
+  // ready. ScrollPreview() indexes further lines as they come into view.
+  PreviewDocument *SelectedPreview() {
+    std::string path = SelectedPath();
+    if (!io_worker_) {
+      return &preview_cache_.get(path);
+    }
+    bool reload = false;
+    PreviewCache::Loaded previous;
+    auto *document = preview_cache_.peek(path, reload, previous);
+    if (reload) {
+      std::size_t lines = PreviewRows() + 1;
+      io_worker_->submit([self = this, path, previous, lines] {
+        auto loaded = PreviewCache::load(path, previous, lines);
+        return std::function<void()>([self, path, loaded] {
+          self->preview_cache_.store(path, loaded);
+          ++self->preview_generation_;
+        });
+      });
+    }
+    return document;
+  }
+
+  // Scroll the note preview from either panel
+  bool HandlePreviewKeys(const Event &event) {
+    int page = PreviewRows();
+    if (event == Event::PageDown) {
+      ScrollPreview(page);
+    } else if (event == Event::PageUp) {
+      ScrollPreview(-page);
+    } else if (event == Event::Character('J')) {
+      ScrollPreview(1);
+    } else if (event == Event::Character('K')) {
+      ScrollPreview(-1);
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  std::string SelectedPath() const {
+    const auto m = model_.month(focused_month_);
+    return get_diary_path(m.year, m.month, selected_day_, config_.diary_dir);
+  }
+
+  // Rows of note text below the month grid: the panel minus its borders,
+  // the weekday header, six weeks and the separator
+  int PreviewRows() const { return std::max(1, layout_.right_top_h - 10); }
+
+  // Start each note from its first line
+  void SyncPreviewScroll() {
+    if (focused_month_ != preview_month_ || selected_day_ != preview_day_) {
+      preview_month_ = focused_month_;
+      preview_day_ = selected_day_;
+      preview_scroll_ = 0;
+    }
+  }
+
+  // Move the preview by delta lines, stopping once the last line is in
+  // view. Lines are only indexed as far as the new position needs.
+  void ScrollPreview(int delta) {
+    SyncPreviewScroll();
+    if (delta < 0) {
+      preview_scroll_ -= std::min<std::size_t>(preview_scroll_, -delta);
+      return;
+    }
+    auto *document = SelectedPreview();
+    if (!document) {
+      return;
+    }
+    std::size_t rows = PreviewRows();
+    std::size_t target = preview_scroll_ + delta;
+    if (!document->has_line(target + rows - 1)) {
+      std::size_t count = document->line_count();
+      target = count > rows ? count - rows : 0;
+    }
+    preview_scroll_ = target;
+  }
+
+  bool HandleSearchKeys(const Event &event, const ClockSnapshot &clock) {
+    if (event == Event::Escape) {
+      search_active_ = false;
+      return true;
+    }
+    if (event == Event::Return) {
+      if (search_query_ != search_ran_query_) {
+        RunSearch();
+      } else if (!search_results_.empty()) {
+        OpenSearchResult(search_results_[search_selected_].match, clock);
+      }
+      return true;
+    }
+    if (event == Event::ArrowDown) {
+      search_selected_ = std::min(search_selected_ + 1,
+                                  int(search_results_.size()) - 1);
+      search_selected_ = std::max(search_selected_, 0);
+      return true;
+    }
+    if (event == Event::ArrowUp) {
+      search_selected_ = std::max(search_selected_ - 1, 0);
+      return true;
+    }
+    if (event == Event::Backspace) {
+      // Drop a whole UTF-8 sequence, not just its last byte
+      while (!search_query_.empty() &&
+             (search_query_.back() & 0xC0) == 0x80) {
+        search_query_.pop_back();
+      }
+      if (!search_query_.empty()) {
+        search_query_.pop_back();
+      }
+      return true;
+    }
+    if (event.is_character()) {
+      search_query_ += event.character();
+      return true;
+    }
+    return true;
+  }
+
+  void RunSearch() {
+    search_results_.clear();
+    search_selected_ = 0;
+    search_ran_query_ = search_query_;
+    bool stale = std::exchange(search_index_stale_, false);
+    if (!io_worker_) {
+      search_results_ = FindMatches(*search_index_, stale, config_.diary_dir,
+                                    search_query_);
+      return;
+    }
+
+    // Results of a query that was replaced meanwhile are dropped
+    search_pending_ = true;
+    io_worker_->submit([self = this, index = search_index_, stale,
+                        dir = config_.diary_dir, query = search_query_] {
+      auto results = FindMatches(*index, stale, dir, query);
+      return std::function<void()>([self, query, results] {
+        if (self->search_ran_query_ == query) {
+          self->search_results_ = results;
+          self->search_pending_ = false;
+        }
+      });
+    });
+  }
+
+  struct SearchResult {
+    SearchIndex::Match match;
+    std::string snippet;
+  };
+
+  // Update the index if stale, then query it and read a snippet for each
+  // match; all of it filesystem work
+  static std::vector<SearchResult> FindMatches(SearchIndex &index,
+                                               bool stale,
+                                               const std::string &diary_dir,
+                                               const std::string &query) {
+    if (stale) {
+      index.update(diary_dir);
+    }
+    std::vector<SearchResult> results;
+    for (const auto &match : index.search(query)) {
+      if (results.size() >= kMaxSearchResults) {
+        break;
+      }
+      std::string path =
+          get_diary_path(match.year, match.month, match.day, diary_dir);
+      results.push_back({match, SearchIndex::snippet(path, query)});
+    }
+    return results;
+  }
+
+  void OpenSearchResult(const SearchIndex::Match &match,
+                        const ClockSnapshot &clock) {
+    int idx = model_.month_index(match.year, match.month);
+    if (idx < 0) {
+      status_message_ = "That entry is outside the calendar range.";
       return;
     }
-    const auto &m = months_[focused_month_];
+    SetFocusedMonth(idx, clock);
+    selected_day_ = match.day;
+    ClampSelectedDay();
+    active_panel_ = Panel::Month;
+    search_active_ = false;
+  }
+
+  void ActivateSelectedDay(const ClockSnapshot &clock) {
+    if (model_.month_count() == 0) {
+      return;
+    }
+    const auto m = model_.month(focused_month_);
     int day = selected_day_;
     int target_days = days_from_epoch(m.year, m.month, day);
-    int today_days = TodayDays();
-    if (target_days > today_days) {
+    if (target_days > clock.days) {
       status_message_ = "Cannot create a diary entry in the future.";
       return;
     }
@@ -367,7 +768,24 @@ private:
     }
   }
 
-  void HandleMouse(const Mouse &mouse) {
+  void HandleMouse(const Mouse &mouse, const ClockSnapshot &clock) {
+    bool wheel =
+        mouse.button == Mouse::WheelUp || mouse.button == Mouse::WheelDown;
+    if (search_active_ && mouse.x >= layout_.right_x &&
+        mouse.y < layout_.right_top_h) {
+      // The search panel covers the month grid and the preview; the wheel
+      // moves through the results, clicks do nothing
+      if (wheel && !search_results_.empty()) {
+        int last = static_cast<int>(search_results_.size()) - 1;
+        search_selected_ += mouse.button == Mouse::WheelUp ? -1 : 1;
+        search_selected_ = std::clamp(search_selected_, 0, last);
+      }
+      return;
+    }
+    if (wheel && mouse.x >= layout_.right_x && mouse.y < layout_.right_top_h) {
+      ScrollPreview(mouse.button == Mouse::WheelUp ? -3 : 3);
+      return;
+    }
     if (mouse.button != Mouse::Left || mouse.motion != Mouse::Released) {
       return;
     }
@@ -384,7 +802,7 @@ private:
       int cell = row * layout_.left_cols + col;
       if (cell >= 0 && cell < layout_.left_cell_count) {
         int month_idx = cell * layout_.left_months_per_cell;
-        SetFocusedMonth(month_idx);
+        SetFocusedMonth(month_idx, clock);
         active_panel_ = Panel::Life;
       }
       return;
@@ -394,22 +812,21 @@ private:
         y >= layout_.month_grid_y && y < layout_.month_grid_y + 6) {
       int col = (x - layout_.month_grid_x) / 3;
       int row = y - layout_.month_grid_y;
-      int first_wd = weekday_index(months_[focused_month_].year,
-                                   months_[focused_month_].month, 1);
+      const auto m = model_.month(focused_month_);
+      int first_wd = weekday_index(m.year, m.month, 1);
       int day = row * 7 + col - first_wd + 1;
-      int num_days = days_in_month(months_[focused_month_].year,
-                                   months_[focused_month_].month);
+      int num_days = days_in_month(m.year, m.month);
       if (day >= 1 && day <= num_days) {
         selected_day_ = day;
         active_panel_ = Panel::Month;
-        ActivateSelectedDay();
+        ActivateSelectedDay(clock);
       }
       return;
     }
   }
 
   void UpdateLayout() {
-    auto term = Terminal::Size();
+    auto term = size_source_ ? size_source_() : Terminal::Size();
     layout_.width = std::max(1, term.dimx);
     layout_.height = std::max(1, term.dimy);
 
@@ -428,7 +845,13 @@ private:
     layout_.right_h = layout_.height;
 
     layout_.right_bottom_h = 3;
-    layout_.right_top_h = std::max(1, layout_.right_h - layout_.right_bottom_h);
+    // The stats panel only takes rows the month panel can spare
+    layout_.right_stats_h =
+        layout_.right_h - layout_.right_bottom_h - 5 >= kMinMonthPanelHeight
+            ? 5
+            : 0;
+    layout_.right_top_h = std::max(1, layout_.right_h - layout_.right_bottom_h -
+                                          layout_.right_stats_h);
 
     layout_.left_grid_x = layout_.left_x + 1;
     layout_.left_grid_y = layout_.left_y + 1;
@@ -438,7 +861,7 @@ private:
     layout_.left_cols = std::max(1, layout_.left_grid_w);
     layout_.left_rows = std::max(1, layout_.left_grid_h);
 
-    int total_months = static_cast<int>(months_.size());
+    int total_months = model_.month_count();
     int cell_count = layout_.left_cols * layout_.left_rows;
     layout_.left_months_per_cell =
         std::max(1, (total_months + cell_count - 1) / cell_count);
@@ -454,11 +877,87 @@ private:
     layout_.month_grid_y = layout_.right_y + 2;
   }
 
-  Element RenderLifeCalendar() {
+  static Element RenderLegend() {
+    return hbox({
+        text("#") | color(Color::RGB(90, 140, 220)),
+        text(" Past  ") | color(Color::GrayLight),
+        text("#") | color(Color::Green),
+        text(" Full  ") | color(Color::GrayLight),
+        text("#") | color(Color::Yellow),
+        text(" Current  ") | color(Color::GrayLight),
+        text("#") | color(Color::GrayDark),
+        text(" Future") | color(Color::GrayLight),
+    });
+  }
+
+  static Element RenderHeatLegend() {
+    Elements cells = {text("Less ") | color(Color::GrayLight)};
+    for (int level = 0; level < kHeatLevels; ++level) {
+      cells.push_back(text("#") | color(HeatColor(level)));
+    }
+    cells.push_back(text(" More  ") | color(Color::GrayLight));
+    cells.push_back(text("#") | color(Color::GrayDark));
+    cells.push_back(text(" Future") | color(Color::GrayLight));
+    return hbox(std::move(cells));
+  }
+
+  // Empty, then four greens from least to most written
+  static constexpr int kHeatLevels = 5;
+  static Color HeatColor(int level) {
+    static const Color kLevels[kHeatLevels] = {
+        Color::RGB(60, 60, 60), Color::RGB(14, 68, 41),
+        Color::RGB(0, 109, 50), Color::RGB(38, 166, 65),
+        Color::RGB(57, 211, 83)};
+    return kLevels[std::clamp(level, 0, kHeatLevels - 1)];
+  }
+
+  // Entry counts are bounded by the days in a cell and scale linearly;
+  // sizes span orders of magnitude, so they are compared on a log scale
+  int HeatLevel(std::int64_t value, std::int64_t max) const {
+    if (value <= 0 || max <= 0) {
+      return 0;
+    }
+    double share = heatmap_ == Heatmap::Bytes
+                       ? std::log1p(double(value)) / std::log1p(double(max))
+                       : double(value) / double(max);
+    return 1 + std::min(kHeatLevels - 2,
+                        static_cast<int>(share * (kHeatLevels - 1)));
+  }
+
+  static Element RenderWeekdayHeader() {
+    return hbox({
+        text("Su ") | color(Color::GrayLight),
+        text("Mo ") | color(Color::GrayLight),
+        text("Tu ") | color(Color::GrayLight),
+        text("We ") | color(Color::GrayLight),
+        text("Th ") | color(Color::GrayLight),
+        text("Fr ") | color(Color::GrayLight),
+        text("Sa ") | color(Color::GrayLight),
+    });
+  }
+
+  Element RenderLifeGrid() {
     Elements rows;
     rows.reserve(layout_.left_rows);
 
-    int total_months = static_cast<int>(months_.size());
+    int total_months = model_.month_count();
+
+    // Volume per cell from the model's prefix sums: one subtraction per
+    // cell however many months it covers
+    std::vector<std::int64_t> heat;
+    std::int64_t heat_max = 0;
+    if (heatmap_ != Heatmap::Off) {
+      heat.resize(layout_.left_cell_count);
+      for (int cell = 0; cell < layout_.left_cell_count; ++cell) {
+        int first = cell * layout_.left_months_per_cell;
+        int last =
+            std::min(first + layout_.left_months_per_cell, total_months);
+        heat[cell] = heatmap_ == Heatmap::Entries
+                         ? model_.entries_between(first, last)
+                         : model_.bytes_between(first, last);
+        heat_max = std::max(heat_max, heat[cell]);
+      }
+    }
 
     for (int r = 0; r < layout_.left_rows; ++r) {
       Elements cols;
@@ -473,28 +972,21 @@ private:
         int end_idx =
             std::min(start_idx + layout_.left_months_per_cell, total_months);
 
-        bool has_current = false;
-        bool has_past = false;
-        bool has_future = false;
-        bool all_full = true;
-        for (int i = start_idx; i < end_idx; ++i) {
-          const auto &m = months_[i];
-          has_current = has_current || m.is_current;
-          has_past = has_past || m.is_past;
-          has_future = has_future || m.is_future;
-          all_full = all_full && m.has_full_diary;
-        }
+        auto span = model_.span(start_idx, end_idx);
 
         Color fg = Color::GrayDark;
-        if (has_current) {
+        if (span.has_current) {
           fg = Color::Yellow;
-        } else if (all_full && has_past) {
+        } else if (span.all_full && span.has_past) {
           fg = Color::Green;
-        } else if (has_past) {
+        } else if (span.has_past) {
           fg = Color::RGB(90, 140, 220);
-        } else if (has_future) {
+        } else if (span.has_future) {
           fg = Color::GrayDark;
         }
+        if (heatmap_ != Heatmap::Off && (span.has_past || span.has_current)) {
+          fg = HeatColor(HeatLevel(heat[cell], heat_max));
+        }
 
         auto elem = text("#") | color(fg);
 
@@ -510,54 +1002,89 @@ private:
       }
       rows.push_back(hbox(std::move(cols)));
     }
+    return vbox(std::move(rows));
+  }
+
+  // Shown in place of the status message until the diary is read
+  Element RenderDiaryProgress() const {
+    if (diary_to_scan_ == 0) {
+      return text("Reading diary...") | color(Color::GrayLight);
+    }
+    std::ostringstream years;
+    years << " " << diary_scanned_ << "/" << diary_to_scan_ << " years";
+    return hbox({
+        text("Reading diary ") | color(Color::GrayLight),
+        gauge(float(diary_scanned_) / float(diary_to_scan_)) |
+            size(WIDTH, EQUAL, 10) | color(Color::Cyan),
+        text(years.str()) | color(Color::GrayLight),
+    });
+  }
 
+  Element RenderLifeCalendar(Element grid) {
     std::string title = "Life Calendar";
-    const auto &m = months_[focused_month_];
+    const auto m = model_.month(focused_month_);
     std::ostringstream info;
-    info << month_name(m.month) << " " << m.year << "  "
-         << (m.has_full_diary ? "Full month diary" : "Month incomplete");
-
-    auto legend = hbox({
-        text("#") | color(Color::RGB(90, 140, 220)),
-        text(" Past  ") | color(Color::GrayLight),
-        text("#") | color(Color::Green),
-        text(" Full  ") | color(Color::GrayLight),
-        text("#") | color(Color::Yellow),
-        text(" Current  ") | color(Color::GrayLight),
-        text("#") | color(Color::GrayDark),
-        text(" Future") | color(Color::GrayLight),
-    });
+    info << month_name(m.month) << " " << m.year << "  ";
+    if (heatmap_ == Heatmap::Off) {
+      info << (m.has_full_diary ? "Full month diary" : "Month incomplete");
+    } else {
+      info << m.entries << (m.entries == 1 ? " entry  " : " entries  ")
+           << format_bytes(m.bytes);
+    }
 
-    auto status = vbox({
+    Elements status = {
         text(info.str()) | color(Color::White),
-        text(status_message_.empty() ? "" : status_message_) |
-            color(Color::RedLight),
-        legend,
-    });
+        diary_loading_ && status_message_.empty()
+            ? RenderDiaryProgress()
+            : text(status_message_) | color(Color::RedLight),
+        heatmap_ == Heatmap::Off ? legend_ : heat_legend_,
+    };
+    if (profile::enabled()) {
+      status.push_back(RenderProfile());
+    }
 
     return window(text(title) | bold | color(Color::Cyan),
                   vbox({
-                      vbox(std::move(rows)) | flex,
+                      grid | flex,
                       separator() | color(Color::GrayDark),
-                      status,
+                      vbox(std::move(status)),
                   }));
   }
 
-  Element RenderMonthCalendar() {
-    const auto &m = months_[focused_month_];
+  // The --profile overlay: frame and input latency, filesystem calls of
+  // the last frame, and the slow operations outside rendering
+  static Element RenderProfile() {
+    auto frame = profile::stats(profile::Timer::Frame);
+    auto input = profile::stats(profile::Timer::EventToFrame);
+    auto refresh = profile::stats(profile::Timer::RefreshDiaryStatus);
+    auto editor = profile::stats(profile::Timer::EditorRoundTrip);
+    auto clock = profile::stats(profile::Timer::ClockSnapshot);
+    auto fs = profile::fs_last_frame();
+
+    std::ostringstream line1, line2, line3;
+    line1 << "frame " << format_ms(frame.last_ms) << " avg "
+          << format_ms(frame.avg_ms) << " p99 " << format_ms(frame.p99_ms)
+          << "  input->frame " << format_ms(input.last_ms) << " p99 "
+          << format_ms(input.p99_ms);
+    line2 << "fs/frame " << fs.stats << " stat " << fs.opens << " open "
+          << format_bytes(fs.bytes_read) << "  clock "
+          << format_ms(clock.avg_ms) << " x" << clock.count;
+    line3 << "refresh " << format_ms(refresh.last_ms) << " x" << refresh.count
+          << "  editor " << format_ms(editor.last_ms) << " x" << editor.count;
+    return vbox({
+        text(line1.str()) | color(Color::Magenta),
+        text(line2.str()) | color(Color::Magenta),
+        text(line3.str()) | color(Color::Magenta),
+    });
+  }
+
+  Element RenderMonthCalendar(const ClockSnapshot &clock) {
+    const auto m = model_.month(focused_month_);
     int num_days = days_in_month(m.year, m.month);
     int first_wd = weekday_index(m.year, m.month, 1);
 
     Elements lines;
-    lines.push_back(hbox({
-        text("Su ") | color(Color::GrayLight),
-        text("Mo ") | color(Color::GrayLight),
-        text("Tu ") | color(Color::GrayLight),
-        text("We ") | color(Color::GrayLight),
-        text("Th ") | color(Color::GrayLight),
-        text("Fr ") | color(Color::GrayLight),
-        text("Sa ") | color(Color::GrayLight),
-    }));
+    lines.push_back(weekday_header_);
 
     for (int row = 0; row < 6; ++row) {
       Elements cols;
@@ -573,17 +1100,16 @@ private:
         oss << std::setw(2) << day_num << " ";
         auto elem = text(oss.str());
 
-        int ty = 0, tm = 0, td = 0;
-        get_today(ty, tm, td);
-        bool is_today = (m.year == ty && m.month == tm && day_num == td);
+        bool is_today = (m.year == clock.year && m.month == clock.month &&
+                         day_num == clock.day);
         if (is_today) {
           elem = elem | color(Color::Yellow) | bold;
         }
 
         int target_days = days_from_epoch(m.year, m.month, day_num);
-        if (target_days > TodayDays()) {
+        if (target_days > clock.days) {
           elem = elem | color(Color::GrayDark);
-        } else if (diary_exists(m.year, m.month, day_num, config_.diary_dir)) {
+        } else if (model_.has_diary(focused_month_, day_num)) {
           elem = elem | color(Color::Green);
         }
 
@@ -600,18 +1126,32 @@ private:
       lines.push_back(hbox(std::move(cols)));
     }
 
+    SyncPreviewScroll();
+    auto *document = SelectedPreview();
+    std::size_t rows = PreviewRows();
+    int width = std::max(1, layout_.right_w - 2);
+    Elements preview_elems;
+    std::string_view line;
+    for (std::size_t r = 0;
+         document && r < rows && document->line(preview_scroll_ + r, line);
+         ++r) {
+      preview_elems.push_back(text(fit_to_width(line, width)));
+    }
+    if (preview_elems.empty()) {
+      preview_elems.push_back(text(document ? "No note yet." : "Loading...") |
+                              color(Color::GrayDark));
+    }
+
     std::ostringstream title;
     title << month_name(m.month) << " " << m.year;
-
-    auto preview_lines = preview_diary_lines(
-        get_diary_path(m.year, m.month, selected_day_, config_.diary_dir), 100);
-    Elements preview_elems;
-    if (preview_lines.empty()) {
-      preview_elems.push_back(text("No note yet.") | color(Color::GrayDark));
-    } else {
-      for (const auto &line : preview_lines) {
-        preview_elems.push_back(text(line));
-      }
+    // Which lines are in view once the note does not fit; the total stays
+    // open until the note has been indexed to its end
+    if (document && (preview_scroll_ > 0 ||
+                     document->has_line(preview_scroll_ + rows))) {
+      title << "  " << preview_scroll_ + 1 << "-"
+            << preview_scroll_ + preview_elems.size() << "/"
+            << document->lines_indexed()
+            << (document->fully_indexed() ? "" : "+");
     }
 
     return window(text(title.str()) | bold | color(Color::Cyan),
@@ -622,15 +1162,69 @@ private:
                   }));
   }
 
-  Element RenderCountdown() {
+  void UpdateCountdownVisibility() {
+    bool visible = layout_.left_w + layout_.right_w <= layout_.width &&
+                   layout_.height > layout_.right_bottom_h;
+    if (countdown_visible_ == visible) {
+      return;
+    }
+    countdown_visible_ = visible;
+    if (on_countdown_visibility_) {
+      on_countdown_visibility_(visible);
+    }
+  }
+
+  Element RenderSearch() {
+    Elements rows;
+    if (search_pending_ && search_query_ == search_ran_query_) {
+      rows.push_back(text("Searching...") | color(Color::GrayDark));
+    } else if (search_ran_query_.empty() ||
+               search_query_ != search_ran_query_) {
+      rows.push_back(text("Enter: search   Esc: close") |
+                     color(Color::GrayDark));
+    } else if (search_results_.empty()) {
+      rows.push_back(text("No matches.") | color(Color::GrayDark));
+    }
+    for (std::size_t i = 0; i < search_results_.size(); ++i) {
+      const auto &result = search_results_[i];
+      auto row = hbox({
+          text(format_date(result.match.year, result.match.month,
+                           result.match.day)) |
+              color(Color::Green),
+          text("  " + result.snippet),
+      });
+      if (static_cast<int>(i) == search_selected_) {
+        row = row | inverted | focus;
+      }
+      rows.push_back(row);
+    }
+
+    std::ostringstream title;
+    title << "Search";
+    if (!search_ran_query_.empty()) {
+      title << " (" << search_results_.size() << " matches)";
+    }
+
+    return window(text(title.str()) | bold | color(Color::Cyan),
+                  vbox({
+                      hbox({
+                          text("/ ") | color(Color::Yellow),
+                          text(search_query_),
+                          text("_") | color(Color::GrayDark),
+                      }),
+                      separator() | color(Color::GrayDark),
+                      vbox(std::move(rows)) | yframe | flex,
+                  }));
+  }
+
+  Element RenderCountdown(const ClockSnapshot &clock) {
     using namespace std::chrono;
-    auto now = current_zone()->to_local(system_clock::now());
     auto target = local_days{year{config_.death_year} /
                              month{static_cast<unsigned>(config_.death_month)} /
                              day{static_cast<unsigned>(config_.death_day)}} +
                   days{1};
 
-    auto diff = target - now;
+    auto diff = target - clock.now;
     if (diff < seconds(0)) {
       diff = seconds(0);
     }
@@ -652,14 +1246,98 @@ private:
                   text(time_oss.str()) | bold | color(Color::White));
   }
 
+  // Journaling statistics under the countdown: streaks, coverage of this
+  // month and year, and how much has been written. The summary is worked
+  // out again only when the model changes or the day rolls over.
+  Element RenderStats(const ClockSnapshot &clock) {
+    if (diary_loading_) {
+      return window(text("Stats") | bold | color(Color::Cyan),
+                    text("Reading diary...") | color(Color::GrayDark));
+    }
+    if (stats_generation_ != model_generation_ || stats_days_ != clock.days) {
+      stats_summary_ = model_.stats().summary(model_.diary_index(), clock.days);
+      stats_generation_ = model_generation_;
+      stats_days_ = clock.days;
+    }
+    const auto &s = stats_summary_;
+
+    std::ostringstream streak, coverage, volume;
+    streak << "Streak " << s.current_streak << "d  best " << s.longest_streak
+           << "d";
+    coverage << "Month " << std::lround(s.month_coverage * 100) << "%  Year "
+             << std::lround(s.year_coverage * 100) << "%";
+    volume << s.entries << " entries  " << format_count(s.words)
+           << " words  " << format_bytes(s.bytes);
+
+    return window(text("Stats") | bold | color(Color::Cyan),
+                  vbox({
+                      text(streak.str()) | color(Color::White),
+                      text(coverage.str()) | color(Color::White),
+                      text(volume.str()) | color(Color::GrayLight),
+                  }));
+  }
+
+  // Rows the month panel needs: borders, weekday header, six weeks, the
+  // separator and one line of preview
+  static constexpr int kMinMonthPanelHeight = 11;
+
   Config config_;
+  LifeModel model_;
   std::function<void(int year, int month, int day)> on_select_day_;
-  std::vector<MonthInfo> months_;
+  std::function<void(bool visible)> on_countdown_visibility_;
+  std::optional<bool> countdown_visible_;
+  std::function<Dimensions()> size_source_;
+  PreviewCache preview_cache_;
+  // First line of the note in view, and the day it belongs to
+  std::size_t preview_scroll_ = 0;
+  int preview_month_ = -1;
+  int preview_day_ = 0;
+
+  static constexpr std::size_t kMaxSearchResults = 200;
+
+  // Shared with the I/O worker, which is then the only one touching it
+  std::shared_ptr<SearchIndex> search_index_;
+  bool search_index_stale_ = true;
+  bool search_pending_ = false;
+  bool search_active_ = false;
+  std::string search_query_;
+  std::string search_ran_query_;
+  std::vector<SearchResult> search_results_;
+  int search_selected_ = 0;
   LayoutInfo layout_;
   Panel active_panel_ = Panel::Life;
+  Heatmap heatmap_ = Heatmap::Off;
   int focused_month_ = 0;
   int selected_day_ = 1;
   std::string status_message_;
+
+  // Bumped whenever the model or the diary index change
+  unsigned model_generation_ = 0;
+  Element life_grid_;
+  LifePanelKey life_grid_key_;
+  Element month_panel_;
+  MonthPanelKey month_panel_key_;
+  Element legend_;
+  Element heat_legend_;
+  Element weekday_header_;
+  DiaryStats::Summary stats_summary_;
+  unsigned stats_generation_ = ~0u;
+  int stats_days_ = 0;
+
+  // Diary status is first read on the first render, so that a poster set
+  // after construction is used for it
+  bool diary_requested_ = false;
+  bool diary_loading_ = false;
+  static constexpr auto kProgressInterval = std::chrono::milliseconds(50);
+  // Year directories rescanned so far while loading, and how many need it
+  std::size_t diary_scanned_ = 0;
+  std::size_t diary_to_scan_ = 0;
+  // Bumped whenever a preview arrives from the I/O worker
+  unsigned preview_generation_ = 0;
+  // The worker's copy of the model; only the worker touches it
+  std::shared_ptr<LifeModel> io_model_;
+  // Last, so it is stopped before anything its results refer to is gone
+  std::unique_ptr<IoWorker> io_worker_;
 };
 
 void CalendarHandle::RefreshDiaryStatus() {
@@ -668,6 +1346,58 @@ void CalendarHandle::RefreshDiaryStatus() {
   }
 }
 
+void CalendarHandle::RefreshDay(int year, int month, int day) {
+  if (impl) {
+    impl->RefreshDay(year, month, day);
+  }
+}
+
+void CalendarHandle::ApplyDiaryChanges(
+    const std::vector<DiaryChange> &changes) {
+  if (impl) {
+    impl->ApplyDiaryChanges(changes);
+  }
+}
+
+void CalendarHandle::SaveModel() {
+  if (impl) {
+    impl->SaveModel();
+  }
+}
+
+void CalendarHandle::SetStatusMessage(std::string message) {
+  if (impl) {
+    impl->SetStatusMessage(std::move(message));
+  }
+}
+
+bool CalendarHandle::CapturesInput() const {
+  return impl && impl->CapturesInput();
+}
+
+void CalendarHandle::SetCountdownVisibilityCallback(
+    std::function<void(bool visible)> cb) {
+  if (impl) {
+    impl->SetCountdownVisibilityCallback(std::move(cb));
+  }
+}
+
+void CalendarHandle::SetSizeSource(std::function<Dimensions()> source) {
+  if (impl) {
+    impl->SetSizeSource(std::move(source));
+  }
+}
+
+void CalendarHandle::SetIoPoster(IoWorker::Deliver post) {
+  if (impl) {
+    impl->SetIoPoster(std::move(post));
+  }
+}
+
+Element CalendarHandle::RenderSection(CalendarSection section) {
+  return impl ? impl->RenderSection(section) : text("");
+}
+
 CalendarHandle MakeLifeCalendarApp(
     const Config &config,
     std::function<void(int year, int month, int day)> on_select_day) {
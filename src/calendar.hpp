@@ -3,6 +3,10 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
+
+#include "diary_watcher.hpp"
+#include "io_worker.hpp"
 
 struct Config; // forward declare
 
@@ -17,15 +21,52 @@ struct DayInfo {
 };
 
 #include <ftxui/component/component.hpp>
+#include <ftxui/screen/terminal.hpp>
 
 // Opaque handle to refresh diary status after editor closes
 class CalendarGridBase;
 
+// The separately drawn parts of a frame
+enum class CalendarSection { Life, Month, Countdown, Stats };
+
 struct CalendarHandle {
   ftxui::Component component;
   std::shared_ptr<CalendarGridBase> impl;
 
   void RefreshDiaryStatus();
+
+  // Re-check a single day after it was edited
+  void RefreshDay(int year, int month, int day);
+
+  // Apply changes reported by DiaryWatcher, rescanning only what they touch
+  void ApplyDiaryChanges(const std::vector<DiaryChange> &changes);
+
+  // Write the diary index and statistics cache back if entries changed
+  // since the last save; call once the UI loop has ended
+  void SaveModel();
+
+  // Show message below the life grid until the next day is opened
+  void SetStatusMessage(std::string message);
+
+  // True while the calendar consumes keys as text, e.g. in the search box
+  bool CapturesInput() const;
+
+  // Called from rendering whenever the countdown enters or leaves the screen
+  void SetCountdownVisibilityCallback(std::function<void(bool visible)> cb);
+
+  // Where the layout reads the screen size from; Terminal::Size() unless
+  // set, e.g. to render into an off-screen ftxui::Screen
+  void SetSizeSource(std::function<ftxui::Dimensions()> source);
+
+  // Do diary, preview and search I/O on a background thread instead of in
+  // event handlers and rendering. post is called on that thread with what
+  // applies a result and must run it on the UI thread, e.g. through
+  // ScreenInteractive::Post. Call before the first render.
+  void SetIoPoster(IoWorker::Deliver post);
+
+  // Build one section from scratch, bypassing the element cache, so its
+  // cost can be measured on its own
+  ftxui::Element RenderSection(CalendarSection section);
 };
 
 // Create the FTXUI life calendar component.
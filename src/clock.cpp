@@ -0,0 +1,27 @@
+#include "clock.hpp"
+#include "date.hpp"
+#include "profile.hpp"
+
+#include <ctime>
+
+ClockSnapshot take_clock_snapshot() {
+  using namespace std::chrono;
+  profile::ScopedTimer timer(profile::Timer::ClockSnapshot);
+  ClockSnapshot clock;
+  clock.now = current_zone()->to_local(system_clock::now());
+
+  year_month_day ymd{floor<days>(clock.now)};
+  clock.year = int(ymd.year());
+  clock.month = unsigned(ymd.month());
+  clock.day = unsigned(ymd.day());
+  clock.days = days_from_epoch(clock.year, clock.month, clock.day);
+  return clock;
+}
+
+int local_today_days() {
+  std::time_t now = std::time(nullptr);
+  std::tm local{};
+  localtime_r(&now, &local);
+  return days_from_epoch(local.tm_year + 1900, local.tm_mon + 1,
+                         local.tm_mday);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <chrono>
+
+// Wall-clock reading taken once per event or render pass.
+// Every consumer of a pass sees the same "today", and the time zone
+// conversion happens once instead of once per call site.
+struct ClockSnapshot {
+  int year = 0;
+  int month = 0;
+  int day = 0;
+  int days = 0; // today as days_from_epoch()
+  std::chrono::local_time<std::chrono::system_clock::duration> now{};
+};
+
+// Read the system clock and convert it to local time. The first call in a
+// process loads the tz database, which takes milliseconds.
+[[nodiscard]] ClockSnapshot take_clock_snapshot();
+
+// Today as days_from_epoch(), from localtime_r(): it only reads the zone
+// file in effect, so one-shot CLI modes answer without loading the tz
+// database
+[[nodiscard]] int local_today_days();
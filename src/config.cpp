@@ -1,17 +1,28 @@
 #include "config.hpp"
+#include "clock.hpp"
+#include "date.hpp"
+#include "diary_template.hpp"
+#include "editor.hpp"
 
 #include <charconv>
 #include <chrono>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <sstream>
 #include <stdexcept>
 #include <string_view>
+#include <vector>
 // toml++ removed as we move to NixOS options/env vars
 
 namespace fs = std::filesystem;
 
+namespace {
+// Beyond this the ticker's period would round down to nothing
+constexpr int kMaxTickRate = 1000;
+} // namespace
+
 std::string expand_home(const std::string &path) {
   if (path.empty() || path[0] != '~')
     return path;
@@ -40,47 +51,19 @@ bool parse_date(std::string_view s, int &y, int &m, int &d) {
   return m >= 1 && m <= 12 && d >= 1 && d <= 31;
 }
 
-static bool is_leap(int y) {
-  return (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0);
-}
-
-static int days_in_month(int y, int m) {
-  static const int dm[] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-  if (m == 2 && is_leap(y))
-    return 29;
-  return dm[m];
-}
-
-int days_from_epoch(int y, int m, int d) {
-  // Days from 0000-01-01 (a simple calculation for comparison purposes)
-  int total = 0;
-  for (int i = 1; i < y; ++i) {
-    total += is_leap(i) ? 366 : 365;
-  }
-  for (int i = 1; i < m; ++i) {
-    total += days_in_month(y, i);
-  }
-  total += d;
-  return total;
+std::string format_date(int y, int m, int d) {
+  std::ostringstream oss;
+  oss << y << "-" << std::setfill('0') << std::setw(2) << m << "-"
+      << std::setfill('0') << std::setw(2) << d;
+  return oss.str();
 }
 
 void get_today(int &y, int &m, int &d) {
-  using namespace std::chrono;
-  auto today = floor<days>(current_zone()->to_local(system_clock::now()));
-  year_month_day ymd{today};
-  y = int(ymd.year());
-  m = unsigned(ymd.month());
-  d = unsigned(ymd.day());
+  date_from_epoch(local_today_days(), y, m, d);
 }
 
 void get_yesterday(int &y, int &m, int &d) {
-  using namespace std::chrono;
-  auto yesterday =
-      floor<days>(current_zone()->to_local(system_clock::now())) - days{1};
-  year_month_day ymd{yesterday};
-  y = int(ymd.year());
-  m = unsigned(ymd.month());
-  d = unsigned(ymd.day());
+  date_from_epoch(local_today_days() - 1, y, m, d);
 }
 
 Config load_config(const std::string &explicit_path) {
@@ -127,34 +110,39 @@ Config load_config(const std::string &explicit_path) {
 
   cfg.birth_date_str = get_env("LIFE_CALENDAR_BIRTH_DATE", "2000-01-01");
   cfg.death_date_str = get_env("LIFE_CALENDAR_DEATH_DATE", "2080-01-01");
-  cfg.editor = get_env("LIFE_CALENDAR_EDITOR", get_env("EDITOR", "vi"));
+  std::string editor =
+      get_env("LIFE_CALENDAR_EDITOR", get_env("EDITOR", "vi"));
+  // A bad editor command only matters once an entry is opened, so it is
+  // kept for the TUI to report rather than failing the one-shot modes
+  if (!split_command(editor, cfg.editor)) {
+    cfg.editor.clear();
+    cfg.editor_error = "Invalid editor command: " + editor;
+  } else if (cfg.editor.empty()) {
+    cfg.editor = {"vi"};
+  }
+  std::string remote_editor = get_env("LIFE_CALENDAR_REMOTE_EDITOR", "");
+  if (!split_command(remote_editor, cfg.remote_editor)) {
+    cfg.remote_editor.clear();
+    cfg.remote_editor_error = "Invalid remote editor command: " +
+                              remote_editor;
+  }
   cfg.diary_dir = get_env("LIFE_CALENDAR_DIARY_DIR", "~/.life-calendar/diary");
   cfg.diary_template =
       get_env("LIFE_CALENDAR_DIARY_TEMPLATE", "~/.life-calendar/template.md");
+  cfg.diary_template_fallback =
+      get_env("LIFE_CALENDAR_DIARY_TEMPLATE_FALLBACK", "");
 
   // Expand ~ in paths
   cfg.diary_dir = expand_home(cfg.diary_dir);
   cfg.diary_template = expand_home(cfg.diary_template);
 
-  // If the user's template doesn't exist, try to create it from the Nix store
-  // fallback or a default header
-  if (!fs::exists(cfg.diary_template)) {
-    try {
-      fs::create_directories(fs::path(cfg.diary_template).parent_path());
-
-      std::string fallback_template =
-          get_env("LIFE_CALENDAR_DIARY_TEMPLATE_FALLBACK", "");
-      if (!fallback_template.empty() && fs::exists(fallback_template)) {
-        fs::copy_file(fallback_template, cfg.diary_template);
-      } else {
-        std::ofstream ofs(cfg.diary_template);
-        ofs << "# Diary Entry: {date}\n\n## What happened today?\n- \n\n## "
-               "Mood / Energy\n- \n\n## Reflection\n- \n";
-      }
-    } catch (...) {
-      // Ignore errors in template creation, we'll handle missing template in
-      // open_diary
-    }
+  std::string tick_rate_str = get_env("LIFE_CALENDAR_TICK_RATE", "1");
+  const char *tick_end = tick_rate_str.data() + tick_rate_str.size();
+  auto tick_res =
+      std::from_chars(tick_rate_str.data(), tick_end, cfg.tick_rate);
+  if (tick_res.ec != std::errc{} || tick_res.ptr != tick_end ||
+      cfg.tick_rate < 0 || cfg.tick_rate > kMaxTickRate) {
+    throw std::runtime_error("Invalid tick_rate: " + tick_rate_str);
   }
 
   // Parse dates
@@ -169,5 +157,31 @@ Config load_config(const std::string &explicit_path) {
                              cfg.death_date_str);
   }
 
+  cfg.entry_template = std::make_shared<DiaryTemplate>(
+      cfg.diary_template,
+      days_from_epoch(cfg.birth_year, cfg.birth_month, cfg.birth_day),
+      days_from_epoch(cfg.death_year, cfg.death_month, cfg.death_day));
+
   return cfg;
 }
+
+void install_diary_template(const Config &config) {
+  if (fs::exists(config.diary_template)) {
+    return;
+  }
+  try {
+    fs::create_directories(fs::path(config.diary_template).parent_path());
+
+    const auto &fallback_template = config.diary_template_fallback;
+    if (!fallback_template.empty() && fs::exists(fallback_template)) {
+      fs::copy_file(fallback_template, config.diary_template);
+    } else {
+      std::ofstream ofs(config.diary_template);
+      ofs << "# Diary Entry: {date}\n\n## What happened today?\n- \n\n## "
+             "Mood / Energy\n- \n\n## Reflection\n- \n";
+    }
+  } catch (...) {
+    // Ignore errors in template creation, we'll handle missing template in
+    // open_diary
+  }
+}
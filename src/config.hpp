@@ -1,14 +1,35 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
+
+class DiaryTemplate;
 
 struct Config {
   std::string birth_date_str;
   std::string death_date_str;
-  std::string editor;
+  // Editor command split into arguments; the diary path is appended
+  std::vector<std::string> editor;
+  // Command handing the path to a running editor server instead, e.g.
+  // nvim --server ~/.cache/nvim.sock --remote; empty when not set
+  std::vector<std::string> remote_editor;
+  // Why editor or remote_editor could not be parsed, in which case it is
+  // empty; reported when an entry is opened
+  std::string editor_error;
+  std::string remote_editor_error;
   std::string diary_dir;
   std::string diary_template;
+  // Copied to diary_template by install_diary_template(), e.g. from the
+  // Nix store; may be empty
+  std::string diary_template_fallback;
+  // diary_template compiled; shared so that copies of the config share
+  // its reloads
+  std::shared_ptr<DiaryTemplate> entry_template;
+
+  // Countdown refreshes per second, 0 disables the live countdown
+  int tick_rate = 1;
 
   // Parsed dates (days since epoch)
   int birth_year{}, birth_month{}, birth_day{};
@@ -21,14 +42,19 @@ struct Config {
 // 3. ~/.config/life-calendar/config.toml
 [[nodiscard]] Config load_config(const std::string &explicit_path = "");
 
+// If the user's template doesn't exist, create it from the fallback or a
+// default header. Only the TUI calls this, so one-shot queries never
+// write to the home directory.
+void install_diary_template(const Config &config);
+
 // Expand ~ to home directory
 [[nodiscard]] std::string expand_home(const std::string &path);
 
 // Parse "YYYY-MM-DD" into year/month/day
 [[nodiscard]] bool parse_date(std::string_view s, int &y, int &m, int &d);
 
-// Convert y/m/d to days since a fixed epoch (0000-01-01)
-[[nodiscard]] int days_from_epoch(int y, int m, int d);
+// Format year/month/day as "YYYY-MM-DD"
+[[nodiscard]] std::string format_date(int y, int m, int d);
 
 // Get today's date components
 void get_today(int &y, int &m, int &d);
@@ -0,0 +1,398 @@
+#include "daemon.hpp"
+#include "clock.hpp"
+#include "date.hpp"
+#include "diary_stats.hpp"
+#include "diary_watcher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+// How long a client may take to send its next query
+constexpr auto kClientTimeout = std::chrono::milliseconds(1000);
+constexpr std::size_t kMaxQueryLength = 256;
+// Connections served at once; more wait in the listen backlog
+constexpr std::size_t kMaxClients = 64;
+
+// A connected client, served from the poll loop alongside the others
+struct Client {
+  int fd = -1;
+  std::string in;  // received, not yet answered
+  std::string out; // answered, not yet sent
+  bool closing = false; // close once out is sent
+  std::chrono::steady_clock::time_point deadline;
+};
+
+int g_signal_pipe[2] = {-1, -1};
+
+void on_signal(int) {
+  char c = 0;
+  ssize_t n = ::write(g_signal_pipe[1], &c, 1);
+  (void)n;
+}
+
+bool make_address(const std::string &path, sockaddr_un &addr) {
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return false;
+  }
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+int connect_to(const std::string &path) {
+  sockaddr_un addr;
+  if (!make_address(path, addr)) {
+    return -1;
+  }
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool send_all(int fd, std::string_view data) {
+  while (!data.empty()) {
+    ssize_t n = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data.remove_prefix(std::size_t(n));
+  }
+  return true;
+}
+
+// Send what the socket takes without blocking; false on error
+bool flush(Client &client) {
+  while (!client.out.empty()) {
+    ssize_t n = ::send(client.fd, client.out.data(), client.out.size(),
+                       MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return true;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    client.out.erase(0, std::size_t(n));
+  }
+  return true;
+}
+
+std::string parent_dir(const std::string &socket_path) {
+  std::string dir = socket_path.substr(0, socket_path.rfind('/') + 1);
+  return dir.empty() ? "." : dir;
+}
+
+// The socket's directory must belong to this user and be writable by
+// nobody else, or another user could have put a socket of their own in
+// its place
+bool check_private_dir(const std::string &dir, std::string &error) {
+  struct stat st;
+  if (::lstat(dir.c_str(), &st) != 0) {
+    error = "Cannot stat " + dir + ": " + std::strerror(errno);
+    return false;
+  }
+  if (!S_ISDIR(st.st_mode) || st.st_uid != ::getuid() ||
+      (st.st_mode & 022) != 0) {
+    error = dir + " is not a directory only this user can write to";
+    return false;
+  }
+  return true;
+}
+
+// check_private_dir() on the socket's directory, creating it when missing
+bool private_parent_dir(const std::string &socket_path, std::string &error) {
+  std::string dir = parent_dir(socket_path);
+  if (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+    error = "Cannot create " + dir + ": " + std::strerror(errno);
+    return false;
+  }
+  return check_private_dir(dir, error);
+}
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+    s.remove_prefix(1);
+  }
+  while (!s.empty() &&
+         (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) {
+    s.remove_suffix(1);
+  }
+  return s;
+}
+} // namespace
+
+DiaryDaemon::DiaryDaemon(const Config &config) : config_(config) {}
+
+std::string DiaryDaemon::answer(std::string_view query) {
+  query = trim(query);
+  auto clock = take_clock_snapshot();
+
+  std::lock_guard lock(mutex_);
+  auto has = [&](int days) {
+    int y = 0, m = 0, d = 0;
+    date_from_epoch(days, y, m, d);
+    return index_.has_diary(y, m, d);
+  };
+
+  if (query == "today") {
+    return has(clock.days) ? "true" : "false";
+  }
+  if (query == "yesterday") {
+    return has(clock.days - 1) ? "true" : "false";
+  }
+  if (query.starts_with("date ")) {
+    int y = 0, m = 0, d = 0;
+    if (!parse_date(trim(query.substr(5)), y, m, d)) {
+      return "error: expected date YYYY-MM-DD";
+    }
+    return index_.has_diary(y, m, d) ? "true" : "false";
+  }
+  if (query == "streak") {
+    return std::to_string(current_streak(index_, clock.days));
+  }
+  return "error: unknown query";
+}
+
+int DiaryDaemon::run(const std::string &socket_path) {
+  sockaddr_un addr;
+  if (!make_address(socket_path, addr)) {
+    std::cerr << "Socket path is too long: " << socket_path << "\n";
+    return 1;
+  }
+  if (std::string error; !private_parent_dir(socket_path, error)) {
+    std::cerr << error << "\n";
+    return 1;
+  }
+
+  // A socket file nobody answers on is left over from a crash
+  if (int fd = connect_to(socket_path); fd >= 0) {
+    ::close(fd);
+    std::cerr << "A daemon is already listening on " << socket_path << "\n";
+    return 1;
+  }
+  ::unlink(socket_path.c_str());
+
+  int listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  mode_t old_mask = ::umask(0077);
+  bool bound = listen_fd >= 0 &&
+               ::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr),
+                      sizeof(addr)) == 0;
+  ::umask(old_mask);
+  if (!bound || ::listen(listen_fd, 16) != 0) {
+    std::cerr << "Cannot listen on " << socket_path << ": "
+              << std::strerror(errno) << "\n";
+    if (listen_fd >= 0) {
+      ::close(listen_fd);
+    }
+    return 1;
+  }
+
+  {
+    std::lock_guard lock(mutex_);
+    if (index_.load(config_.diary_dir)) {
+      index_.save(config_.diary_dir);
+    }
+  }
+  // Load the time zone database now rather than on the first query
+  (void)take_clock_snapshot();
+
+  DiaryWatcher watcher;
+  watcher.start(config_.diary_dir, [this](std::vector<DiaryChange> changes) {
+    std::lock_guard lock(mutex_);
+    for (const auto &change : changes) {
+      switch (change.kind) {
+      case DiaryChange::Kind::Entry:
+        index_.update_entry(config_.diary_dir, change.year, change.month,
+                            change.day);
+        break;
+      case DiaryChange::Kind::Year:
+        index_.scan_year(config_.diary_dir, change.year);
+        break;
+      case DiaryChange::Kind::All:
+        index_.load(config_.diary_dir);
+        break;
+      }
+    }
+  });
+
+  if (::pipe(g_signal_pipe) != 0) {
+    std::cerr << "Cannot create signal pipe\n";
+    ::close(listen_fd);
+    return 1;
+  }
+  struct sigaction sa{};
+  sa.sa_handler = on_signal;
+  ::sigaction(SIGINT, &sa, nullptr);
+  ::sigaction(SIGTERM, &sa, nullptr);
+
+  // Answer every complete query line a client has sent so far
+  auto serve = [this](Client &client) {
+    std::size_t newline;
+    while ((newline = client.in.find('\n')) != std::string::npos) {
+      client.out += answer(std::string_view(client.in).substr(0, newline));
+      client.out += '\n';
+      client.in.erase(0, newline + 1);
+    }
+    if (client.in.size() > kMaxQueryLength) {
+      client.out += "error: query too long\n";
+      client.in.clear();
+      client.closing = true;
+    }
+  };
+
+  // Every client is served from this one loop, a query at a time as its
+  // lines arrive, so a slow or idle client holds up nobody else
+  std::vector<Client> clients;
+  std::vector<pollfd> fds;
+  char chunk[512];
+  while (true) {
+    using std::chrono::steady_clock;
+    auto now = steady_clock::now();
+    int timeout = -1;
+    fds.assign({{g_signal_pipe[0], POLLIN, 0}, {listen_fd, POLLIN, 0}});
+    if (clients.size() >= kMaxClients) {
+      fds[1].events = 0;
+    }
+    for (const auto &client : clients) {
+      short events = client.out.empty() ? POLLIN : POLLOUT;
+      fds.push_back({client.fd, events, 0});
+      auto left = std::chrono::ceil<std::chrono::milliseconds>(
+          client.deadline - now);
+      int ms = std::max(0, static_cast<int>(left.count()));
+      timeout = timeout < 0 ? ms : std::min(timeout, ms);
+    }
+    if (::poll(fds.data(), fds.size(), timeout) < 0) {
+      continue;
+    }
+    if (fds[0].revents & POLLIN) {
+      break;
+    }
+
+    now = steady_clock::now();
+    for (std::size_t i = 0; i < clients.size(); ++i) {
+      auto &client = clients[i];
+      short revents = fds[i + 2].revents;
+      bool keep = true;
+      if (revents & POLLOUT) {
+        keep = flush(client) && !(client.closing && client.out.empty());
+      } else if (revents & (POLLIN | POLLHUP | POLLERR)) {
+        ssize_t n = ::read(client.fd, chunk, sizeof(chunk));
+        if (n > 0) {
+          client.in.append(chunk, std::size_t(n));
+          client.deadline = now + kClientTimeout;
+          serve(client);
+        } else if (n == 0 || (errno != EINTR && errno != EAGAIN)) {
+          // A last query without a trailing newline is still answered
+          if (n == 0 && !trim(client.in).empty()) {
+            client.out += answer(client.in) + "\n";
+          }
+          client.in.clear();
+          client.closing = true;
+        }
+        keep = flush(client) && !(client.closing && client.out.empty());
+      } else if (now >= client.deadline) {
+        keep = false;
+      }
+      if (!keep) {
+        ::close(client.fd);
+        client.fd = -1;
+      }
+    }
+    std::erase_if(clients, [](const Client &c) { return c.fd < 0; });
+
+    if (fds[1].revents & POLLIN) {
+      int fd = ::accept4(listen_fd, nullptr, nullptr,
+                         SOCK_CLOEXEC | SOCK_NONBLOCK);
+      if (fd >= 0) {
+        clients.push_back({fd, {}, {}, false, now + kClientTimeout});
+      }
+    }
+  }
+
+  for (const auto &client : clients) {
+    ::close(client.fd);
+  }
+  watcher.stop();
+  ::close(listen_fd);
+  ::unlink(socket_path.c_str());
+  ::close(g_signal_pipe[0]);
+  ::close(g_signal_pipe[1]);
+  return 0;
+}
+
+std::string daemon_socket_path() {
+  if (const char *runtime = std::getenv("XDG_RUNTIME_DIR");
+      runtime && *runtime) {
+    return std::string(runtime) + "/life-calendar.sock";
+  }
+  return "/tmp/life-calendar-" + std::to_string(::getuid()) +
+         "/life-calendar.sock";
+}
+
+bool query_daemon(const std::string &socket_path, std::string_view query,
+                  std::string &reply, std::string &error) {
+  // Only a daemon creates the directory; a client just refuses one that
+  // others could have planted a socket in
+  std::string dir = parent_dir(socket_path);
+  struct stat st;
+  if (::lstat(dir.c_str(), &st) != 0 && errno == ENOENT) {
+    error = "No daemon is listening on " + socket_path;
+    return false;
+  }
+  if (!check_private_dir(dir, error)) {
+    return false;
+  }
+  int fd = connect_to(socket_path);
+  if (fd < 0) {
+    error = "No daemon is listening on " + socket_path;
+    return false;
+  }
+  bool sent = send_all(fd, std::string(query) + "\n");
+  if (!sent) {
+    error = "Lost the connection to the daemon on " + socket_path;
+  }
+  ::shutdown(fd, SHUT_WR);
+
+  reply.clear();
+  char chunk[512];
+  ssize_t n;
+  while (sent && (n = ::read(fd, chunk, sizeof(chunk))) != 0) {
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    reply.append(chunk, std::size_t(n));
+  }
+  ::close(fd);
+  if (!reply.empty() && reply.back() == '\n') {
+    reply.pop_back();
+  }
+  return sent;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "config.hpp"
+#include "diary_index.hpp"
+
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Answers diary queries from status bars over a Unix socket, keeping the
+// diary index and the time zone loaded between queries. A DiaryWatcher
+// keeps the index current while it runs.
+//
+// One query per line, one reply line per query:
+//   today, yesterday, date YYYY-MM-DD   true or false
+//   streak                              days in a row with an entry,
+//                                       ending today, or yesterday while
+//                                       today has no entry yet
+//   anything else                       error: <reason>
+class DiaryDaemon {
+public:
+  explicit DiaryDaemon(const Config &config);
+
+  // Listen on socket_path until SIGINT or SIGTERM; returns an exit code
+  int run(const std::string &socket_path);
+
+  // Reply to a single query line
+  [[nodiscard]] std::string answer(std::string_view query);
+
+private:
+  Config config_;
+  std::mutex mutex_; // guards index_, updated from the watcher thread
+  DiaryIndex index_;
+};
+
+// $XDG_RUNTIME_DIR/life-calendar.sock, or the same name in a 0700
+// per-user directory in /tmp
+[[nodiscard]] std::string daemon_socket_path();
+
+// Send one query to a running daemon. Returns false with a message in
+// error when no daemon is listening on socket_path, or when the socket's
+// directory is not private to this user.
+bool query_daemon(const std::string &socket_path, std::string_view query,
+                  std::string &reply, std::string &error);
@@ -0,0 +1,119 @@
+#pragma once
+
+// Civil (proleptic Gregorian) date arithmetic.
+// days_from_epoch / date_from_epoch use the closed-form days-from-civil and
+// civil-from-days algorithms, so every helper here is O(1) and constexpr.
+
+[[nodiscard]] constexpr bool is_leap(int y) {
+  return (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0);
+}
+
+[[nodiscard]] constexpr int days_in_month(int y, int m) {
+  constexpr int dm[] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  if (m == 2 && is_leap(y)) {
+    return 29;
+  }
+  return dm[m];
+}
+
+// Convert y/m/d to days since 1970-01-01 (negative before it)
+[[nodiscard]] constexpr int days_from_epoch(int y, int m, int d) {
+  // Years are counted from March so the leap day falls at the end
+  y -= m <= 2;
+  const int era = (y >= 0 ? y : y - 399) / 400;
+  const int yoe = y - era * 400;
+  const int doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// Convert days since 1970-01-01 back to y/m/d
+constexpr void date_from_epoch(int days, int &y, int &m, int &d) {
+  days += 719468;
+  const int era = (days >= 0 ? days : days - 146096) / 146097;
+  const int doe = days - era * 146097;
+  const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const int mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = yoe + era * 400 + (m <= 2);
+}
+
+// Day of week for a day count, 0 = Sunday
+[[nodiscard]] constexpr int weekday_from_epoch(int days) {
+  return days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6;
+}
+
+// Day of week for y/m/d, 0 = Sunday
+[[nodiscard]] constexpr int weekday_index(int y, int m, int d) {
+  return weekday_from_epoch(days_from_epoch(y, m, d));
+}
+
+// ISO 8601 week number, 1-53, for a day count. Weeks start on Monday and
+// week 1 is the one holding its year's first Thursday.
+[[nodiscard]] constexpr int iso_week_from_epoch(int days) {
+  const int thursday = days - (weekday_from_epoch(days) + 6) % 7 + 3;
+  int y = 0, m = 0, d = 0;
+  date_from_epoch(thursday, y, m, d);
+  return (thursday - days_from_epoch(y, 1, 1)) / 7 + 1;
+}
+
+namespace date_checks {
+struct Sample {
+  int y, m, d;
+  int days;
+  int weekday;
+};
+
+constexpr Sample kSamples[] = {
+    {1970, 1, 1, 0, 4},        {1969, 12, 31, -1, 3},
+    {2000, 1, 1, 10957, 6},    {2000, 2, 29, 11016, 2},
+    {2000, 3, 1, 11017, 3},    {1900, 3, 1, -25508, 4},
+    {2024, 12, 31, 20088, 2},  {2080, 1, 1, 40177, 1},
+    {1, 1, 1, -719162, 1},     {0, 3, 1, -719468, 3},
+    {-1, 12, 31, -719529, 5},  {9999, 12, 31, 2932896, 5},
+};
+
+constexpr bool round_trips(const Sample &s) {
+  int y = 0, m = 0, d = 0;
+  date_from_epoch(s.days, y, m, d);
+  return days_from_epoch(s.y, s.m, s.d) == s.days &&
+         weekday_index(s.y, s.m, s.d) == s.weekday && y == s.y && m == s.m &&
+         d == s.d;
+}
+
+constexpr bool all_samples_round_trip() {
+  for (const auto &s : kSamples) {
+    if (!round_trips(s)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+constexpr bool consecutive_over_range(int first_year, int last_year) {
+  int expected = days_from_epoch(first_year, 1, 1);
+  for (int y = first_year; y <= last_year; ++y) {
+    for (int m = 1; m <= 12; ++m) {
+      if (days_from_epoch(y, m, 1) != expected) {
+        return false;
+      }
+      expected += days_in_month(y, m);
+    }
+  }
+  return true;
+}
+
+static_assert(all_samples_round_trip());
+static_assert(consecutive_over_range(1890, 2110));
+static_assert(days_in_month(1900, 2) == 28 && days_in_month(2000, 2) == 29 &&
+              days_in_month(2023, 2) == 28 && days_in_month(2024, 2) == 29);
+static_assert(iso_week_from_epoch(days_from_epoch(2021, 1, 3)) == 53 &&
+              iso_week_from_epoch(days_from_epoch(2021, 1, 4)) == 1 &&
+              iso_week_from_epoch(days_from_epoch(2024, 12, 30)) == 1 &&
+              iso_week_from_epoch(days_from_epoch(2026, 10, 17)) == 42 &&
+              iso_week_from_epoch(days_from_epoch(1969, 12, 29)) == 1);
+static_assert(!is_leap(1900) && is_leap(2000) && is_leap(2024) &&
+              !is_leap(2100));
+} // namespace date_checks
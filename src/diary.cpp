@@ -1,13 +1,46 @@
 #include "diary.hpp"
+#include "config.hpp"
+#include "date.hpp"
+#include "diary_template.hpp"
+#include "editor.hpp"
+#include "preview_document.hpp"
+#include "profile.hpp"
 
+#include <atomic>
+#include <cerrno>
+#include <charconv>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace fs = std::filesystem;
 
+static bool stat_path(const std::string &path, mode_t type, FileStat &out) {
+  profile::count_stat();
+  struct stat st{};
+  if (::stat(path.c_str(), &st) != 0 || (st.st_mode & S_IFMT) != type) {
+    return false;
+  }
+  out.size = st.st_size;
+  out.mtime_ns =
+      std::int64_t(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+  return true;
+}
+
+bool stat_file(const std::string &path, FileStat &out) {
+  return stat_path(path, S_IFREG, out);
+}
+
+bool stat_dir(const std::string &path, FileStat &out) {
+  return stat_path(path, S_IFDIR, out);
+}
+
 std::string get_diary_path(int year, int month, int day,
                            const std::string &diary_dir) {
   std::ostringstream oss;
@@ -17,48 +50,107 @@ std::string get_diary_path(int year, int month, int day,
   return oss.str();
 }
 
-bool diary_exists(int year, int month, int day, const std::string &diary_dir) {
-  return fs::exists(get_diary_path(year, month, day, diary_dir));
+bool write_file_atomically(const std::string &path, std::string_view data) {
+  // Unique per call, so saves from several threads never share a file
+  static std::atomic<unsigned> sequence{0};
+  std::string tmp_path = path + ".tmp." + std::to_string(::getpid()) + "." +
+                         std::to_string(sequence.fetch_add(1));
+  {
+    std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!ofs || !ofs.write(data.data(), std::streamsize(data.size())) ||
+        !ofs.flush()) {
+      std::error_code ec;
+      fs::remove(tmp_path, ec);
+      return false;
+    }
+  }
+  std::error_code ec;
+  fs::rename(tmp_path, path, ec);
+  if (ec) {
+    fs::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
 }
 
-static std::string read_file(const std::string &path) {
-  std::ifstream ifs(path);
-  if (!ifs) {
-    return "";
+bool read_file(const std::string &path, std::string &out) {
+  out.clear();
+  profile::count_open();
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
   }
-  std::ostringstream oss;
-  oss << ifs.rdbuf();
-  return oss.str();
+  struct stat st{};
+  if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+  // Sized from fstat, but grown if the file was appended to meanwhile
+  out.resize(static_cast<std::size_t>(st.st_size) + 1);
+  std::size_t used = 0;
+  for (;;) {
+    if (used == out.size()) {
+      out.resize(out.size() * 2);
+    }
+    ssize_t n = ::read(fd, out.data() + used, out.size() - used);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    used += static_cast<std::size_t>(n);
+  }
+  ::close(fd);
+  out.resize(used);
+  profile::count_bytes_read(used);
+  return true;
+}
+
+std::string get_diary_year_dir(int year, const std::string &diary_dir) {
+  return diary_dir + "/" + std::to_string(year);
 }
 
-static void replace_all(std::string &text, const std::string &from,
-                        const std::string &to) {
-  if (from.empty()) {
-    return;
+bool parse_diary_filename(std::string_view name, int &year, int &month,
+                          int &day) {
+  if (name.size() != 13 || !name.ends_with(".md")) {
+    return false;
   }
-  std::size_t start = 0;
-  while ((start = text.find(from, start)) != std::string::npos) {
-    text.replace(start, from.size(), to);
-    start += to.size();
+  return parse_date(name.substr(0, 10), year, month, day) &&
+         day <= days_in_month(year, month);
+}
+
+bool parse_diary_year_dir(std::string_view name, int &year) {
+  if (name.size() != 4) {
+    return false;
   }
+  auto res = std::from_chars(name.data(), name.data() + name.size(), year);
+  return res.ec == std::errc{} && res.ptr == name.data() + name.size();
 }
 
-static std::string apply_template(const std::string &templ, int year, int month,
-                                  int day) {
-  std::ostringstream date_oss;
-  date_oss << year << "-" << std::setfill('0') << std::setw(2) << month << "-"
-           << std::setfill('0') << std::setw(2) << day;
-  std::string out = templ;
-  replace_all(out, "{date}", date_oss.str());
-  replace_all(out, "{year}", std::to_string(year));
-  replace_all(out, "{month}", std::to_string(month));
-  replace_all(out, "{day}", std::to_string(day));
-  return out;
+bool diary_exists(int year, int month, int day, const std::string &diary_dir) {
+  profile::count_stat();
+  return fs::exists(get_diary_path(year, month, day, diary_dir));
 }
 
-void open_diary(int year, int month, int day, const std::string &editor,
-                const std::string &diary_dir,
-                const std::string &diary_template) {
+std::vector<std::string> preview_diary_lines(const std::string &path,
+                                             int max_lines) {
+  std::vector<std::string> lines;
+  PreviewDocument document;
+  if (!document.open(path)) {
+    return lines;
+  }
+  std::string_view line;
+  for (int i = 0; i < max_lines && document.line(i, line); ++i) {
+    lines.push_back(fit_to_width(line, 64));
+  }
+  return lines;
+}
+
+// Create the entry for the day if needed and return its path
+static std::string create_diary(int year, int month, int day,
+                                const std::string &diary_dir,
+                                DiaryTemplate &entry_template) {
   std::string path = get_diary_path(year, month, day, diary_dir);
 
   // Create parent directories
@@ -66,22 +158,33 @@ void open_diary(int year, int month, int day, const std::string &editor,
 
   // If file doesn't exist, create it with a header or template
   if (!fs::exists(path)) {
-    std::ofstream ofs(path);
-    std::string templ = diary_template.empty() ? "" : read_file(diary_template);
-    if (!templ.empty()) {
-      ofs << apply_template(templ, year, month, day);
-      if (templ.back() != '\n') {
-        ofs << "\n";
-      }
-    } else {
-      ofs << "# Diary - " << year << "-" << std::setfill('0') << std::setw(2)
-          << month << "-" << std::setfill('0') << std::setw(2) << day << "\n\n";
-    }
+    entry_template.refresh();
+    std::string text;
+    entry_template.expand(year, month, day, text);
+    std::ofstream ofs(path, std::ios::binary);
+    ofs.write(text.data(), static_cast<std::streamsize>(text.size()));
     ofs.close();
   }
+  return path;
+}
+
+bool open_diary(int year, int month, int day,
+                const std::vector<std::string> &editor,
+                const std::string &diary_dir,
+                DiaryTemplate &entry_template, std::string &error) {
+  std::string path =
+      create_diary(year, month, day, diary_dir, entry_template);
 
   // Launch editor in the current terminal instance.
   // We rely on ftxui's WithRestoredIO to have restored the terminal state.
-  std::string cmd = editor + " \"" + path + "\"";
-  (void)std::system(cmd.c_str());
+  return run_editor(editor, path, false, error);
+}
+
+bool open_diary_remote(int year, int month, int day,
+                       const std::vector<std::string> &remote_editor,
+                       const std::string &diary_dir,
+                       DiaryTemplate &entry_template, std::string &error) {
+  std::string path =
+      create_diary(year, month, day, diary_dir, entry_template);
+  return run_editor(remote_editor, path, true, error);
 }
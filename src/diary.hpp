@@ -1,18 +1,73 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
+
+class DiaryTemplate;
+
+// Size and modification time of a file or directory
+struct FileStat {
+  std::int64_t size = 0;
+  std::int64_t mtime_ns = 0;
+
+  bool operator==(const FileStat &) const = default;
+};
+
+// stat() a regular file, returning false if it is missing or not a file
+bool stat_file(const std::string &path, FileStat &out);
+
+// stat() a directory, returning false if it is missing or not a directory
+bool stat_dir(const std::string &path, FileStat &out);
 
 // Get the diary file path for a given date
 // Format: diary_dir/YYYY/YYYY-MM-DD.md
 std::string get_diary_path(int year, int month, int day,
                            const std::string &diary_dir);
 
+// Replace path with data in one step by writing a temporary file next to
+// it and renaming it over the original, so readers never see partial data
+bool write_file_atomically(const std::string &path, std::string_view data);
+
+// Read a whole regular file into out with read(), returning false if it
+// cannot be opened. Unlike a mapping, a file truncated by another tool
+// while it is read just comes up short instead of faulting.
+bool read_file(const std::string &path, std::string &out);
+
+// Get the directory holding one year of entries: diary_dir/YYYY
+std::string get_diary_year_dir(int year, const std::string &diary_dir);
+
+// Parse a diary file name "YYYY-MM-DD.md" into year/month/day
+bool parse_diary_filename(std::string_view name, int &year, int &month,
+                          int &day);
+
+// Parse a year directory name "YYYY"
+bool parse_diary_year_dir(std::string_view name, int &year);
+
 // Check if a diary entry exists for the given date
 bool diary_exists(int year, int month, int day, const std::string &diary_dir);
 
+// Read up to max_lines lines of a diary file for previewing, shortening
+// long lines to 64 columns without splitting UTF-8 characters
+std::vector<std::string> preview_diary_lines(const std::string &path,
+                                             int max_lines);
+
 // Open the diary file in the configured editor.
-// Creates the file and parent directories if they don't exist.
-// This function blocks until the editor is closed.
-void open_diary(int year, int month, int day, const std::string &editor,
+// Creates the file and parent directories if they don't exist, the file
+// from entry_template.
+// This function blocks until the editor is closed. Returns false with a
+// message in error if the editor could not be run or failed.
+bool open_diary(int year, int month, int day,
+                const std::vector<std::string> &editor,
                 const std::string &diary_dir,
-                const std::string &diary_template);
+                DiaryTemplate &entry_template, std::string &error);
+
+// Create the entry like open_diary() but hand it to a remote editor
+// command, which returns once an already running editor server has the
+// file, so the terminal never has to be given up. Returns false if the
+// command failed, e.g. because no server is listening.
+bool open_diary_remote(int year, int month, int day,
+                       const std::vector<std::string> &remote_editor,
+                       const std::string &diary_dir,
+                       DiaryTemplate &entry_template, std::string &error);
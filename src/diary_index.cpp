@@ -0,0 +1,323 @@
+#include "diary_index.hpp"
+#include "date.hpp"
+#include "mapped_file.hpp"
+#include "profile.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include <span>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+using YearRecord = DiaryIndex::YearRecord;
+
+static_assert(std::is_trivially_copyable_v<YearRecord>);
+
+constexpr char kMagic[8] = {'L', 'C', 'I', 'D', 'X', '\0', '\0', '\0'};
+constexpr std::uint32_t kVersion = 1;
+
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t record_size;
+  std::uint64_t record_count;
+};
+
+// Records of a mapped index file, sorted by year; empty if the file is
+// missing, from another version or truncated
+std::span<const YearRecord> saved_records(const MappedFile &file) {
+  if (file.size() < sizeof(FileHeader)) {
+    return {};
+  }
+  FileHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.record_size != sizeof(YearRecord) ||
+      file.size() !=
+          sizeof(FileHeader) + header.record_count * sizeof(YearRecord)) {
+    return {};
+  }
+  return {reinterpret_cast<const YearRecord *>(file.data() + sizeof(header)),
+          static_cast<std::size_t>(header.record_count)};
+}
+
+const YearRecord *find_record(std::span<const YearRecord> records, int year) {
+  auto it = std::lower_bound(
+      records.begin(), records.end(), year,
+      [](const YearRecord &r, int y) { return r.year < y; });
+  return it != records.end() && it->year == year ? &*it : nullptr;
+}
+
+bool valid_day(int month, int day) {
+  return month >= 1 && month <= 12 && day >= 1 && day <= 31;
+}
+
+int day_slot(int month, int day) { return (month - 1) * 31 + (day - 1); }
+
+// List diary_dir/YYYY/ into a fresh record; false if the directory is gone.
+// Touches nothing shared, so several years can be read concurrently.
+bool read_year(const std::string &diary_dir, int year, YearRecord &rec) {
+  rec = YearRecord{};
+  rec.year = year;
+
+  // Taken before listing, so a file added mid-scan makes the stored mtime
+  // stale and the year is listed again next time
+  std::string dir = get_diary_year_dir(year, diary_dir);
+  FileStat dir_stat;
+  if (!stat_dir(dir, dir_stat)) {
+    return false;
+  }
+  rec.dir_mtime_ns = dir_stat.mtime_ns;
+
+  std::error_code ec;
+  profile::count_open();
+  for (fs::directory_iterator it(dir, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    int y = 0, m = 0, d = 0;
+    FileStat stat;
+    if (!parse_diary_filename(it->path().filename().native(), y, m, d) ||
+        y != year || !stat_file(it->path().native(), stat)) {
+      continue;
+    }
+    rec.bits[m - 1] |= 1u << (d - 1);
+    rec.days[day_slot(m, d)] = stat;
+  }
+  return true;
+}
+
+// Stat every entry of rec again, dropping those that are gone; true if
+// anything changed
+bool restat_year(const std::string &diary_dir, YearRecord &rec) {
+  bool changed = false;
+  for (int m = 1; m <= 12; ++m) {
+    for (std::uint32_t bits = rec.bits[m - 1]; bits != 0; bits &= bits - 1) {
+      int d = std::countr_zero(bits) + 1;
+      FileStat stat;
+      if (!stat_file(get_diary_path(rec.year, m, d, diary_dir), stat)) {
+        rec.bits[m - 1] &= ~(1u << (d - 1));
+      }
+      changed = changed || rec.days[day_slot(m, d)] != stat;
+      rec.days[day_slot(m, d)] = stat;
+    }
+  }
+  return changed;
+}
+} // namespace
+
+std::string DiaryIndex::index_path(const std::string &diary_dir) {
+  return diary_dir + "/.life-calendar.idx";
+}
+
+bool DiaryIndex::load(const std::string &diary_dir,
+                      const Progress &progress) {
+  years_.clear();
+
+  MappedFile file(index_path(diary_dir));
+  auto saved = saved_records(file);
+  bool changed = !file.is_open();
+
+  std::set<int> on_disk;
+  std::vector<int> stale;
+  std::error_code ec;
+  profile::count_open();
+  for (fs::directory_iterator it(diary_dir, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    int year = 0;
+    if (!parse_diary_year_dir(it->path().filename().native(), year) ||
+        !it->is_directory(ec)) {
+      continue;
+    }
+    on_disk.insert(year);
+
+    FileStat dir;
+    const YearRecord *rec = find_record(saved, year);
+    if (rec && stat_dir(it->path().native(), dir) &&
+        rec->dir_mtime_ns == dir.mtime_ns) {
+      years_[year] = *rec;
+    } else {
+      // What was saved stands in until the year is rescanned
+      if (rec) {
+        years_[year] = *rec;
+      }
+      stale.push_back(year);
+      changed = true;
+    }
+  }
+
+  if (!progress || stale.empty()) {
+    scan_years(diary_dir, stale);
+  } else {
+    // Recent years first, as those are the ones looked at, and one year
+    // per pool thread at a time so each batch keeps the pool busy
+    std::sort(stale.rbegin(), stale.rend());
+    std::size_t batch = std::max<std::size_t>(io_thread_pool().size(), 1);
+    progress(0, stale.size());
+    for (std::size_t i = 0; i < stale.size(); i += batch) {
+      std::size_t end = std::min(i + batch, stale.size());
+      scan_years(diary_dir,
+                 std::vector<int>(stale.begin() + i, stale.begin() + end));
+      progress(end, stale.size());
+    }
+  }
+
+  // An entry edited in place leaves its directory's mtime alone. Only the
+  // newest year, the one being written to, is stat'ed entry by entry.
+  if (!on_disk.empty() &&
+      std::ranges::find(stale, *on_disk.rbegin()) == stale.end()) {
+    auto it = years_.find(*on_disk.rbegin());
+    if (it != years_.end() && restat_year(diary_dir, it->second)) {
+      changed = true;
+    }
+  }
+
+  // Year directories that were removed since the index was written
+  changed = changed || on_disk.size() != saved.size();
+  return changed;
+}
+
+bool DiaryIndex::save(const std::string &diary_dir) const {
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.record_size = sizeof(YearRecord);
+  header.record_count = years_.size();
+
+  std::string data;
+  data.reserve(sizeof(header) + years_.size() * sizeof(YearRecord));
+  data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  for (const auto &[year, rec] : years_) {
+    data.append(reinterpret_cast<const char *>(&rec), sizeof(rec));
+  }
+  return write_file_atomically(index_path(diary_dir), data);
+}
+
+void DiaryIndex::rebuild(const std::string &diary_dir) {
+  years_.clear();
+
+  std::vector<int> years;
+  std::error_code ec;
+  profile::count_open();
+  for (fs::directory_iterator it(diary_dir, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    int year = 0;
+    if (!parse_diary_year_dir(it->path().filename().native(), year)) {
+      continue;
+    }
+    if (it->is_directory(ec)) {
+      years.push_back(year);
+    }
+  }
+  scan_years(diary_dir, years);
+}
+
+void DiaryIndex::scan_years(const std::string &diary_dir,
+                            const std::vector<int> &years) {
+  if (years.size() <= 1) {
+    for (int year : years) {
+      scan_year(diary_dir, year);
+    }
+    return;
+  }
+
+  // One pool task per year directory, merged here on the calling thread
+  std::vector<YearRecord> records(years.size());
+  std::vector<char> found(years.size(), 0);
+  io_thread_pool().parallel_for(years.size(), [&](std::size_t i) {
+    found[i] = read_year(diary_dir, years[i], records[i]);
+  });
+  for (std::size_t i = 0; i < years.size(); ++i) {
+    if (found[i]) {
+      years_[years[i]] = records[i];
+    } else {
+      years_.erase(years[i]);
+    }
+  }
+}
+
+void DiaryIndex::scan_year(const std::string &diary_dir, int year) {
+  YearRecord rec;
+  if (read_year(diary_dir, year, rec)) {
+    years_[year] = rec;
+  } else {
+    years_.erase(year);
+  }
+}
+
+void DiaryIndex::update_entry(const std::string &diary_dir, int year,
+                              int month, int day) {
+  if (!valid_day(month, day)) {
+    return;
+  }
+  FileStat stat;
+  if (!stat_file(get_diary_path(year, month, day, diary_dir), stat)) {
+    set_diary(year, month, day, false);
+    return;
+  }
+  auto &rec = years_[year];
+  rec.year = year;
+  rec.bits[month - 1] |= 1u << (day - 1);
+  rec.days[day_slot(month, day)] = stat;
+}
+
+void DiaryIndex::set_diary(int year, int month, int day, bool present) {
+  if (!valid_day(month, day)) {
+    return;
+  }
+  std::uint32_t bit = 1u << (day - 1);
+  if (present) {
+    auto &rec = years_[year];
+    rec.year = year;
+    rec.bits[month - 1] |= bit;
+    return;
+  }
+  auto it = years_.find(year);
+  if (it != years_.end()) {
+    it->second.bits[month - 1] &= ~bit;
+    it->second.days[day_slot(month, day)] = FileStat{};
+  }
+}
+
+bool DiaryIndex::has_diary(int year, int month, int day) const {
+  if (!valid_day(month, day)) {
+    return false;
+  }
+  auto it = years_.find(year);
+  return it != years_.end() && (it->second.bits[month - 1] >> (day - 1)) & 1u;
+}
+
+bool DiaryIndex::month_full(int year, int month) const {
+  if (month < 1 || month > 12) {
+    return false;
+  }
+  auto it = years_.find(year);
+  if (it == years_.end()) {
+    return false;
+  }
+  std::uint32_t full = (1u << days_in_month(year, month)) - 1;
+  return (it->second.bits[month - 1] & full) == full;
+}
+
+bool DiaryIndex::entry_stat(int year, int month, int day,
+                            FileStat &out) const {
+  if (!has_diary(year, month, day)) {
+    return false;
+  }
+  out = years_.at(year).days[day_slot(month, day)];
+  return true;
+}
+
+std::uint32_t DiaryIndex::month_bits(int year, int month) const {
+  if (month < 1 || month > 12) {
+    return 0;
+  }
+  auto it = years_.find(year);
+  return it != years_.end() ? it->second.bits[month - 1] : 0;
+}
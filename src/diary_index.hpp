@@ -0,0 +1,89 @@
+#pragma once
+
+#include "diary.hpp"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// In-memory record of which days have a diary entry, with each entry's
+// size and mtime.
+// Built by listing each diary_dir/YYYY/ directory once and parsing the
+// YYYY-MM-DD.md file names, so lookups never touch the filesystem.
+// The index is persisted as diary_dir/.life-calendar.idx and loaded
+// through a memory mapping; only year directories whose mtime changed
+// since it was written are listed again, one thread pool task per year.
+// Editing an entry in place does not change its directory's mtime, so on
+// load the entries of the newest year are stat'ed again; an older entry
+// edited in place while nothing was watching keeps its saved size and
+// mtime until its year is rescanned.
+class DiaryIndex {
+public:
+  // One year of entries. Fixed size and trivially copyable, it is also
+  // the record layout of the persisted index.
+  struct YearRecord {
+    std::int32_t year = 0;
+    std::int32_t reserved = 0;
+    std::int64_t dir_mtime_ns = 0;
+    // Bit (day - 1) of bits[month - 1] is set when that day has an entry
+    std::array<std::uint32_t, 12> bits{};
+    // Indexed by (month - 1) * 31 + (day - 1)
+    std::array<FileStat, 12 * 31> days{};
+  };
+
+  // Called by load() once the saved records are in and again after each
+  // batch of rescanned year directories, with the number rescanned so far
+  // and how many needed it. The index is complete up to that point.
+  using Progress = std::function<void(std::size_t done, std::size_t total)>;
+
+  // Path of the persisted index for diary_dir
+  [[nodiscard]] static std::string index_path(const std::string &diary_dir);
+
+  // Load the persisted index, rescanning year directories that are new or
+  // whose mtime changed. Returns true if the result differs from what was
+  // persisted, i.e. when save() would write something new. With progress,
+  // years are rescanned newest first, a few at a time, and reported.
+  bool load(const std::string &diary_dir, const Progress &progress = {});
+
+  // Atomically replace the persisted index with this one
+  bool save(const std::string &diary_dir) const;
+
+  // Rescan every year directory under diary_dir
+  void rebuild(const std::string &diary_dir);
+
+  // Rescan the single directory diary_dir/YYYY/
+  void scan_year(const std::string &diary_dir, int year);
+
+  // Rescan several year directories in parallel
+  void scan_years(const std::string &diary_dir, const std::vector<int> &years);
+
+  // Re-stat the entry for one day after it was created, edited or removed
+  void update_entry(const std::string &diary_dir, int year, int month,
+                    int day);
+
+  // Record that the entry for the given day was created or removed
+  void set_diary(int year, int month, int day, bool present);
+
+  // Check if a diary entry exists for the given date
+  [[nodiscard]] bool has_diary(int year, int month, int day) const;
+
+  // Check if every day of the given month has a diary entry
+  [[nodiscard]] bool month_full(int year, int month) const;
+
+  // Size and mtime of an entry, false when it does not exist
+  bool entry_stat(int year, int month, int day, FileStat &out) const;
+
+  // Bit (day - 1) is set for each day of the month that has an entry
+  [[nodiscard]] std::uint32_t month_bits(int year, int month) const;
+
+  // Every indexed year, in order
+  [[nodiscard]] const std::map<int, YearRecord> &years() const {
+    return years_;
+  }
+
+private:
+  std::map<int, YearRecord> years_;
+};
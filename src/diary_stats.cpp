@@ -0,0 +1,393 @@
+#include "diary_stats.hpp"
+#include "config.hpp"
+#include "date.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iomanip>
+#include <span>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace {
+using YearRecord = DiaryStats::YearRecord;
+using IndexRecord = DiaryIndex::YearRecord;
+
+static_assert(std::is_trivially_copyable_v<YearRecord>);
+
+constexpr char kMagic[8] = {'L', 'C', 'S', 'T', 'A', 'T', '\0', '\0'};
+constexpr std::uint32_t kVersion = 1;
+
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t record_size;
+  std::uint64_t record_count;
+};
+
+// Records of a mapped cache file, sorted by year; empty if the file is
+// missing, from another version or truncated
+std::span<const YearRecord> saved_records(const MappedFile &file) {
+  if (file.size() < sizeof(FileHeader)) {
+    return {};
+  }
+  FileHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.record_size != sizeof(YearRecord) ||
+      file.size() !=
+          sizeof(FileHeader) + header.record_count * sizeof(YearRecord)) {
+    return {};
+  }
+  return {reinterpret_cast<const YearRecord *>(file.data() + sizeof(header)),
+          static_cast<std::size_t>(header.record_count)};
+}
+
+const YearRecord *find_record(std::span<const YearRecord> records, int year) {
+  auto it = std::lower_bound(
+      records.begin(), records.end(), year,
+      [](const YearRecord &r, int y) { return r.year < y; });
+  return it != records.end() && it->year == year ? &*it : nullptr;
+}
+
+int day_slot(int month, int day) { return (month - 1) * 31 + (day - 1); }
+
+// Bits first..last (1-based days, inclusive) of a month's day bits
+std::uint32_t day_range_mask(int first, int last) {
+  std::uint64_t upto_last = (std::uint64_t{1} << last) - 1;
+  std::uint64_t before_first = (std::uint64_t{1} << (first - 1)) - 1;
+  return static_cast<std::uint32_t>(upto_last & ~before_first);
+}
+
+// Whitespace-separated words, so it works on any UTF-8 text
+std::uint32_t count_words(std::string_view text) {
+  std::uint32_t words = 0;
+  bool in_word = false;
+  for (unsigned char c : text) {
+    bool space = c == ' ' || (c >= '\t' && c <= '\r');
+    words += !space && !in_word;
+    in_word = !space;
+  }
+  return words;
+}
+
+// Fill out with the entries of one indexed year, taking word counts from
+// cached where the entry's stat still matches and reading the file
+// otherwise. Returns true if out differs from cached. Touches nothing
+// shared, so several years can be counted concurrently.
+bool count_year(const std::string &diary_dir, const IndexRecord &index,
+                const YearRecord *cached, YearRecord &out) {
+  out = YearRecord{};
+  out.year = index.year;
+  bool differs = cached == nullptr;
+  std::string text;
+  for (int m = 0; m < 12; ++m) {
+    std::uint32_t bits = index.bits[m];
+    out.bits[m] = bits;
+    differs = differs || cached->bits[m] != bits;
+    for (; bits != 0; bits &= bits - 1) {
+      int day = std::countr_zero(bits);
+      int slot = m * 31 + day;
+      out.days[slot] = index.days[slot];
+      if (cached && (cached->bits[m] >> day & 1u) &&
+          cached->days[slot] == index.days[slot]) {
+        out.words[slot] = cached->words[slot];
+        continue;
+      }
+      read_file(get_diary_path(index.year, m + 1, day + 1, diary_dir), text);
+      out.words[slot] = count_words(text);
+      differs = true;
+    }
+  }
+  return differs;
+}
+
+std::string percent(double share) {
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(1) << share * 100 << "%";
+  return oss.str();
+}
+
+double ratio(int part, int whole) {
+  return whole > 0 ? static_cast<double>(part) / whole : 0.0;
+}
+} // namespace
+
+std::string DiaryStats::cache_path(const std::string &diary_dir) {
+  return diary_dir + "/.life-calendar-stats.idx";
+}
+
+bool DiaryStats::update(const std::string &diary_dir,
+                        const DiaryIndex &index) {
+  MappedFile file(cache_path(diary_dir));
+  auto saved = saved_records(file);
+
+  std::vector<const IndexRecord *> work;
+  for (const auto &[year, rec] : index.years()) {
+    work.push_back(&rec);
+  }
+
+  // One pool task per year, merged here on the calling thread
+  std::vector<YearRecord> records(work.size());
+  std::vector<char> differs(work.size(), 0);
+  io_thread_pool().parallel_for(work.size(), [&](std::size_t i) {
+    differs[i] = count_year(diary_dir, *work[i],
+                            find_record(saved, work[i]->year), records[i]);
+  });
+
+  years_.clear();
+  entries_ = bytes_ = words_ = 0;
+  for (const auto &rec : records) {
+    add_totals(years_[rec.year] = rec, 1);
+  }
+
+  // Years that were removed since the cache was written
+  return !file.is_open() || saved.size() != records.size() ||
+         std::ranges::any_of(differs, [](char c) { return c != 0; });
+}
+
+void DiaryStats::update_year(const std::string &diary_dir,
+                             const DiaryIndex &index, int year) {
+  auto it = years_.find(year);
+  if (it != years_.end()) {
+    add_totals(it->second, -1);
+  }
+  auto indexed = index.years().find(year);
+  if (indexed == index.years().end()) {
+    if (it != years_.end()) {
+      years_.erase(it);
+    }
+    return;
+  }
+
+  YearRecord rec;
+  count_year(diary_dir, indexed->second,
+             it != years_.end() ? &it->second : nullptr, rec);
+  add_totals(years_[year] = rec, 1);
+}
+
+void DiaryStats::update_day(const std::string &diary_dir, int year, int month,
+                            int day) {
+  if (month < 1 || month > 12 || day < 1 || day > 31) {
+    return;
+  }
+  int slot = day_slot(month, day);
+  std::uint32_t bit = 1u << (day - 1);
+
+  // The file itself rather than the index's copy of its stat, so the
+  // count follows the entry whatever the caller did to the index
+  std::string path = get_diary_path(year, month, day, diary_dir);
+  FileStat stat;
+  bool exists = stat_file(path, stat);
+  auto it = years_.find(year);
+  bool counted = it != years_.end() && (it->second.bits[month - 1] & bit);
+  if (counted && exists && it->second.days[slot] == stat) {
+    return;
+  }
+  if (counted) {
+    auto &rec = it->second;
+    --entries_;
+    bytes_ -= rec.days[slot].size;
+    words_ -= rec.words[slot];
+    rec.bits[month - 1] &= ~bit;
+    rec.days[slot] = FileStat{};
+    rec.words[slot] = 0;
+  }
+  if (!exists) {
+    return;
+  }
+
+  auto &rec = years_[year];
+  rec.year = year;
+  rec.bits[month - 1] |= bit;
+  rec.days[slot] = stat;
+  std::string text;
+  read_file(path, text);
+  rec.words[slot] = count_words(text);
+  ++entries_;
+  bytes_ += stat.size;
+  words_ += rec.words[slot];
+}
+
+bool DiaryStats::save(const std::string &diary_dir) const {
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.record_size = sizeof(YearRecord);
+  header.record_count = years_.size();
+
+  std::string data;
+  data.reserve(sizeof(header) + years_.size() * sizeof(YearRecord));
+  data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  for (const auto &[year, rec] : years_) {
+    data.append(reinterpret_cast<const char *>(&rec), sizeof(rec));
+  }
+  return write_file_atomically(cache_path(diary_dir), data);
+}
+
+void DiaryStats::add_totals(const YearRecord &rec, int sign) {
+  for (int m = 0; m < 12; ++m) {
+    for (std::uint32_t bits = rec.bits[m]; bits != 0; bits &= bits - 1) {
+      int slot = m * 31 + std::countr_zero(bits);
+      entries_ += sign;
+      bytes_ += sign * rec.days[slot].size;
+      words_ += sign * static_cast<std::int64_t>(rec.words[slot]);
+    }
+  }
+}
+
+DiaryStats::Summary DiaryStats::summary(const DiaryIndex &index,
+                                        int today_days) const {
+  Summary s;
+  s.entries = entries_;
+  s.bytes = bytes_;
+  s.words = words_;
+  s.current_streak = current_streak(index, today_days);
+
+  // Runs of set bits, a whole run at a time; a run continues into the
+  // next month or year when it starts the day after the previous one ends
+  bool any = false;
+  int run = 0;
+  int run_end = 0;
+  for (const auto &[year, rec] : index.years()) {
+    for (int m = 1; m <= 12; ++m) {
+      std::uint32_t bits =
+          rec.bits[m - 1] & day_range_mask(1, days_in_month(year, m));
+      int month_start = bits != 0 ? days_from_epoch(year, m, 1) : 0;
+      while (bits != 0) {
+        int offset = std::countr_zero(bits);
+        int length = std::countr_one(bits >> offset);
+        int start = month_start + offset;
+        if (!any) {
+          s.first_entry = start;
+          any = true;
+        }
+        run = run > 0 && start == run_end + 1 ? run + length : length;
+        run_end = start + length - 1;
+        if (run > s.longest_streak) {
+          s.longest_streak = run;
+          s.longest_streak_end = run_end;
+        }
+        bits &= ~day_range_mask(offset + 1, offset + length);
+      }
+    }
+  }
+
+  int y = 0, m = 0, d = 0;
+  date_from_epoch(today_days, y, m, d);
+  int month_start = today_days - (d - 1);
+  int year_start = days_from_epoch(y, 1, 1);
+  s.month_coverage = ratio(count_entries(index, month_start, today_days), d);
+  s.year_coverage = ratio(count_entries(index, year_start, today_days),
+                          today_days - year_start + 1);
+  if (any && s.first_entry <= today_days) {
+    s.overall_coverage =
+        ratio(count_entries(index, s.first_entry, today_days),
+              today_days - s.first_entry + 1);
+  }
+  return s;
+}
+
+int count_entries(const DiaryIndex &index, int from_days, int to_days) {
+  if (from_days > to_days) {
+    return 0;
+  }
+  int y = 0, m = 0, first = 0;
+  date_from_epoch(from_days, y, m, first);
+  int month_start = from_days - (first - 1);
+
+  int count = 0;
+  while (month_start <= to_days) {
+    int length = days_in_month(y, m);
+    int last = std::min(length, to_days - month_start + 1);
+    count += std::popcount(index.month_bits(y, m) &
+                           day_range_mask(first, last));
+    month_start += length;
+    first = 1;
+    if (++m > 12) {
+      m = 1;
+      ++y;
+    }
+  }
+  return count;
+}
+
+int current_streak(const DiaryIndex &index, int today_days) {
+  auto has = [&](int days) {
+    int y = 0, m = 0, d = 0;
+    date_from_epoch(days, y, m, d);
+    return index.has_diary(y, m, d);
+  };
+  int day = has(today_days) ? today_days : today_days - 1;
+  int streak = 0;
+  while (has(day - streak)) {
+    ++streak;
+  }
+  return streak;
+}
+
+void write_stats_report(const DiaryIndex &index, const DiaryStats &stats,
+                        int today_days, std::ostream &out) {
+  auto s = stats.summary(index, today_days);
+  auto date = [](int days) {
+    int y = 0, m = 0, d = 0;
+    date_from_epoch(days, y, m, d);
+    return format_date(y, m, d);
+  };
+
+  out << "Entries         " << s.entries << "\n"
+      << "Words           " << s.words << "\n"
+      << "Bytes           " << s.bytes << "\n"
+      << "Current streak  " << s.current_streak << " days\n"
+      << "Longest streak  " << s.longest_streak << " days";
+  if (s.longest_streak > 0) {
+    out << ", ending " << date(s.longest_streak_end);
+  }
+  out << "\n"
+      << "Coverage        " << percent(s.month_coverage) << " this month, "
+      << percent(s.year_coverage) << " this year";
+  if (s.entries == 0 || s.first_entry > today_days) {
+    out << "\n";
+    return;
+  }
+  out << ", " << percent(s.overall_coverage) << " since "
+      << date(s.first_entry) << "\n\n";
+
+  // Per year from the first entry to this year, per month up to today
+  static const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                 "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+  out << "Year  Entries  Coverage";
+  for (const char *name : months) {
+    out << "  " << name;
+  }
+  out << "\n";
+
+  int first_year = 0, today_year = 0, m = 0, d = 0;
+  date_from_epoch(s.first_entry, first_year, m, d);
+  date_from_epoch(today_days, today_year, m, d);
+  for (int y = first_year; y <= today_year; ++y) {
+    int start = days_from_epoch(y, 1, 1);
+    int end = std::min(days_from_epoch(y, 12, 31), today_days);
+    int entries = count_entries(index, start, end);
+    out << std::setw(4) << y << "  " << std::setw(7) << entries << "  "
+        << std::setw(8) << percent(ratio(entries, end - start + 1));
+    for (int month = 1; month <= 12; ++month) {
+      int month_start = days_from_epoch(y, month, 1);
+      if (month_start > today_days) {
+        out << "    -";
+        continue;
+      }
+      int month_end = std::min(
+          days_from_epoch(y, month, days_in_month(y, month)), today_days);
+      double share = ratio(count_entries(index, month_start, month_end),
+                           month_end - month_start + 1);
+      out << std::setw(5) << static_cast<int>(share * 100 + 0.5);
+    }
+    out << "\n";
+  }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "diary_index.hpp"
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+
+// Journaling statistics: streaks and coverage come straight from the
+// index's per-month day bits, volume from word counts cached per entry.
+// An entry is read only when its size or mtime differs from the cached
+// one: as the index recorded it for whole years, which the index stats
+// again when they are rescanned or are the newest, and as stat'ed afresh
+// for single entries. The cache is persisted as
+// diary_dir/.life-calendar-stats.idx in the same fixed-record layout as
+// the diary index.
+class DiaryStats {
+public:
+  // One year of word counts. Fixed size and trivially copyable, it is
+  // also the record layout of the persisted cache.
+  struct YearRecord {
+    std::int32_t year = 0;
+    std::int32_t reserved = 0;
+    // Bit (day - 1) of bits[month - 1] is set when that day was counted
+    std::array<std::uint32_t, 12> bits{};
+    // Indexed by (month - 1) * 31 + (day - 1), as in DiaryIndex
+    std::array<FileStat, 12 * 31> days{};
+    std::array<std::uint32_t, 12 * 31> words{};
+  };
+
+  struct Summary {
+    int current_streak = 0;
+    int longest_streak = 0;
+    int longest_streak_end = 0; // last day of it, as days_from_epoch()
+    int first_entry = 0;        // as days_from_epoch(); 0 without entries
+    std::int64_t entries = 0;
+    std::int64_t bytes = 0;
+    std::int64_t words = 0;
+    // Share of days with an entry, up to and including today
+    double month_coverage = 0;
+    double year_coverage = 0;
+    double overall_coverage = 0; // since the first entry
+  };
+
+  // Path of the persisted cache for diary_dir
+  [[nodiscard]] static std::string cache_path(const std::string &diary_dir);
+
+  // Load the persisted cache and bring it in line with the index,
+  // counting the words of new and changed entries only, one thread pool
+  // task per year. Returns true when save() would write something new.
+  bool update(const std::string &diary_dir, const DiaryIndex &index);
+
+  // Like update(), for one year after it was rescanned
+  void update_year(const std::string &diary_dir, const DiaryIndex &index,
+                   int year);
+
+  // Stat one entry after it was created, edited or removed and count its
+  // words again if its size or mtime changed
+  void update_day(const std::string &diary_dir, int year, int month,
+                  int day);
+
+  // Atomically replace the persisted cache with this one
+  bool save(const std::string &diary_dir) const;
+
+  [[nodiscard]] std::int64_t entries() const { return entries_; }
+  [[nodiscard]] std::int64_t bytes() const { return bytes_; }
+  [[nodiscard]] std::int64_t words() const { return words_; }
+
+  // Streaks, coverage and the running totals as of today
+  [[nodiscard]] Summary summary(const DiaryIndex &index,
+                                int today_days) const;
+
+private:
+  void add_totals(const YearRecord &rec, int sign);
+
+  std::map<int, YearRecord> years_;
+  std::int64_t entries_ = 0;
+  std::int64_t bytes_ = 0;
+  std::int64_t words_ = 0;
+};
+
+// Days in [from_days, to_days] with an entry, one popcount per month
+[[nodiscard]] int count_entries(const DiaryIndex &index, int from_days,
+                                int to_days);
+
+// Days in a row with an entry ending today, or ending yesterday while
+// today has no entry yet
+[[nodiscard]] int current_streak(const DiaryIndex &index, int today_days);
+
+// The --stats report: totals, streaks, and coverage per year and month
+void write_stats_report(const DiaryIndex &index, const DiaryStats &stats,
+                        int today_days, std::ostream &out);
@@ -0,0 +1,156 @@
+#include "diary_template.hpp"
+#include "date.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string_view>
+
+namespace {
+// Used when there is no template file or it is empty
+constexpr std::string_view kDefaultTemplate = "# Diary - {date}\n\n";
+
+constexpr std::string_view kWeekdays[] = {
+    "Sunday",   "Monday", "Tuesday",  "Wednesday",
+    "Thursday", "Friday", "Saturday",
+};
+
+std::string read_file(const std::string &path) {
+  std::ifstream ifs(path);
+  if (!ifs) {
+    return "";
+  }
+  std::ostringstream oss;
+  oss << ifs.rdbuf();
+  return oss.str();
+}
+} // namespace
+
+DiaryTemplate::DiaryTemplate(std::string path, int birth_days, int death_days)
+    : path_(std::move(path)), birth_days_(birth_days),
+      death_days_(death_days) {}
+
+void DiaryTemplate::refresh() {
+  FileStat stat;
+  bool exists = !path_.empty() && stat_file(path_, stat);
+  if (!segments_.empty() && exists == exists_ && stat == stat_) {
+    return;
+  }
+  exists_ = exists;
+  stat_ = stat;
+  compile(exists ? read_file(path_) : std::string());
+}
+
+void DiaryTemplate::compile(std::string text) {
+  if (text.empty()) {
+    text = kDefaultTemplate;
+  } else if (text.back() != '\n') {
+    text += '\n';
+  }
+
+  static constexpr std::pair<std::string_view, Field> kFields[] = {
+      {"date", Field::Date},       {"year", Field::Year},
+      {"month", Field::Month},     {"day", Field::Day},
+      {"weekday", Field::Weekday}, {"week", Field::Week},
+      {"age", Field::Age},         {"days_left", Field::DaysLeft},
+  };
+
+  text_.clear();
+  text_.reserve(text.size());
+  segments_.clear();
+  // Adjacent literals share one segment, as text_ grows contiguously
+  auto add_literal = [&](std::string_view s) {
+    if (s.empty()) {
+      return;
+    }
+    if (segments_.empty() || segments_.back().field != Field::Literal) {
+      segments_.push_back(
+          {Field::Literal, static_cast<std::uint32_t>(text_.size()), 0});
+    }
+    segments_.back().length += static_cast<std::uint32_t>(s.size());
+    text_.append(s);
+  };
+
+  std::string_view rest = text;
+  while (!rest.empty()) {
+    std::size_t open = rest.find('{');
+    if (open == std::string_view::npos) {
+      add_literal(rest);
+      break;
+    }
+    add_literal(rest.substr(0, open));
+    std::size_t close = rest.find('}', open + 1);
+    std::string_view name = close == std::string_view::npos
+                                ? std::string_view()
+                                : rest.substr(open + 1, close - open - 1);
+    auto it = std::find_if(std::begin(kFields), std::end(kFields),
+                           [&](const auto &f) { return f.first == name; });
+    if (it == std::end(kFields)) {
+      add_literal(rest.substr(open, 1));
+      rest.remove_prefix(open + 1);
+      continue;
+    }
+    segments_.push_back({it->second});
+    rest.remove_prefix(close + 1);
+  }
+}
+
+void DiaryTemplate::expand(int year, int month, int day,
+                           std::string &out) const {
+  const int days = days_from_epoch(year, month, day);
+  out.clear();
+  // No placeholder expands to more than 16 bytes
+  out.reserve(text_.size() + segments_.size() * 16);
+
+  char buf[16];
+  auto number = [&](int value, bool two_digits) {
+    char *end = buf;
+    if (two_digits && value >= 0 && value < 10) {
+      *end++ = '0';
+    }
+    end = std::to_chars(end, std::end(buf), value).ptr;
+    out.append(buf, end);
+  };
+
+  for (const auto &segment : segments_) {
+    switch (segment.field) {
+    case Field::Literal:
+      out.append(text_, segment.offset, segment.length);
+      break;
+    case Field::Date:
+      number(year, false);
+      out += '-';
+      number(month, true);
+      out += '-';
+      number(day, true);
+      break;
+    case Field::Year:
+      number(year, false);
+      break;
+    case Field::Month:
+      number(month, false);
+      break;
+    case Field::Day:
+      number(day, false);
+      break;
+    case Field::Weekday:
+      out.append(kWeekdays[weekday_from_epoch(days)]);
+      break;
+    case Field::Week:
+      number(iso_week_from_epoch(days), false);
+      break;
+    case Field::Age: {
+      int by = 0, bm = 0, bd = 0;
+      date_from_epoch(birth_days_, by, bm, bd);
+      int age = year - by - (month < bm || (month == bm && day < bd));
+      number(std::max(age, 0), false);
+      break;
+    }
+    case Field::DaysLeft:
+      number(std::max(death_days_ - days, 0), false);
+      break;
+    }
+  }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "diary.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The template new diary entries are created from, compiled into a list
+// of literal and placeholder segments so that creating an entry is one
+// pass into a buffer sized up front. The file is read again only when its
+// mtime or size change, and not at all before the first refresh(), so
+// loading the config costs nothing for modes that never create an entry.
+//
+// Placeholders: {date} YYYY-MM-DD, {year}, {month}, {day}, {weekday}
+// (e.g. Monday), {week} (ISO 8601 week), {age} (completed years on that
+// day) and {days_left} (days from that day to the death date). Anything
+// else in braces is kept as written.
+class DiaryTemplate {
+public:
+  // path may be empty or missing, in which case a one-line header is used
+  DiaryTemplate(std::string path, int birth_days, int death_days);
+
+  // Compile the file if it changed since it was last compiled, or on the
+  // first call
+  void refresh();
+
+  // The text of a new entry for the date, written over out; as compiled
+  // by the last refresh()
+  void expand(int year, int month, int day, std::string &out) const;
+
+private:
+  enum class Field : std::uint8_t {
+    Literal,
+    Date,
+    Year,
+    Month,
+    Day,
+    Weekday,
+    Week,
+    Age,
+    DaysLeft,
+  };
+
+  struct Segment {
+    Field field = Field::Literal;
+    std::uint32_t offset = 0; // literal text, in text_
+    std::uint32_t length = 0;
+  };
+
+  void compile(std::string text);
+
+  std::string path_;
+  int birth_days_;
+  int death_days_;
+  bool exists_ = false;
+  FileStat stat_;
+  std::string text_; // literal bytes of all segments
+  std::vector<Segment> segments_;
+};
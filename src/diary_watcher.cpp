@@ -0,0 +1,186 @@
+#include "diary_watcher.hpp"
+#include "diary.hpp"
+
+#include <filesystem>
+#include <system_error>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+DiaryWatcher::~DiaryWatcher() { stop(); }
+
+#ifdef __linux__
+
+namespace {
+constexpr uint32_t kEntryMask =
+    IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF |
+    IN_MOVE_SELF | IN_ONLYDIR;
+// Year directories also report entries written in place, which leave the
+// directory itself untouched
+constexpr uint32_t kYearMask = kEntryMask | IN_CLOSE_WRITE;
+} // namespace
+
+bool DiaryWatcher::start(const std::string &diary_dir, Callback on_changes) {
+  stop();
+
+  diary_dir_ = diary_dir;
+  on_changes_ = std::move(on_changes);
+
+  std::error_code ec;
+  fs::create_directories(diary_dir_, ec);
+
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (inotify_fd_ < 0 || wake_fd_ < 0) {
+    stop();
+    return false;
+  }
+
+  root_wd_ = inotify_add_watch(inotify_fd_, diary_dir_.c_str(), kEntryMask);
+  if (root_wd_ < 0) {
+    stop();
+    return false;
+  }
+
+  thread_ = std::thread([this] { run(); });
+  return true;
+}
+
+void DiaryWatcher::stop() {
+  if (thread_.joinable()) {
+    uint64_t one = 1;
+    ssize_t n = write(wake_fd_, &one, sizeof(one));
+    (void)n;
+    thread_.join();
+  }
+  if (inotify_fd_ >= 0) {
+    close(inotify_fd_);
+  }
+  if (wake_fd_ >= 0) {
+    close(wake_fd_);
+  }
+  inotify_fd_ = -1;
+  wake_fd_ = -1;
+  root_wd_ = -1;
+  year_by_wd_.clear();
+}
+
+void DiaryWatcher::watch_year(int year) {
+  std::string dir = diary_dir_ + "/" + std::to_string(year);
+  int wd = inotify_add_watch(inotify_fd_, dir.c_str(), kYearMask);
+  if (wd >= 0) {
+    year_by_wd_[wd] = year;
+  }
+}
+
+void DiaryWatcher::run() {
+  // Listed here rather than in start(), so that a caller drawing its first
+  // frame does not wait for one watch per year directory. Year directories
+  // created meanwhile are reported through the root watch.
+  std::error_code ec;
+  for (fs::directory_iterator it(diary_dir_, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    int year = 0;
+    if (parse_diary_year_dir(it->path().filename().native(), year) &&
+        it->is_directory(ec)) {
+      watch_year(year);
+    }
+  }
+
+  pollfd fds[2] = {
+      {inotify_fd_, POLLIN, 0},
+      {wake_fd_, POLLIN, 0},
+  };
+  while (true) {
+    if (poll(fds, 2, -1) < 0) {
+      continue;
+    }
+    if (fds[1].revents & POLLIN) {
+      return;
+    }
+    if (fds[0].revents & POLLIN) {
+      std::vector<DiaryChange> changes;
+      read_events(changes);
+      if (!changes.empty() && on_changes_) {
+        on_changes_(std::move(changes));
+      }
+    }
+  }
+}
+
+void DiaryWatcher::read_events(std::vector<DiaryChange> &changes) {
+  alignas(inotify_event) char buf[4096];
+  while (true) {
+    ssize_t len = read(inotify_fd_, buf, sizeof(buf));
+    if (len <= 0) {
+      return;
+    }
+
+    for (char *p = buf; p < buf + len;) {
+      auto *ev = reinterpret_cast<inotify_event *>(p);
+      p += sizeof(inotify_event) + ev->len;
+
+      if (ev->mask & IN_Q_OVERFLOW) {
+        changes.push_back({DiaryChange::Kind::All});
+        continue;
+      }
+
+      std::string_view name = ev->len ? ev->name : "";
+      bool appeared = ev->mask & (IN_CREATE | IN_MOVED_TO);
+      bool vanished = ev->mask & (IN_DELETE | IN_MOVED_FROM);
+
+      if (ev->wd == root_wd_) {
+        int year = 0;
+        if (!(ev->mask & IN_ISDIR) || !parse_diary_year_dir(name, year)) {
+          continue;
+        }
+        if (appeared) {
+          // Files may have landed before the watch was added, so the
+          // whole year is rescanned rather than trusting later events.
+          watch_year(year);
+        }
+        if (appeared || vanished) {
+          changes.push_back({DiaryChange::Kind::Year, year});
+        }
+        continue;
+      }
+
+      auto it = year_by_wd_.find(ev->wd);
+      if (it == year_by_wd_.end()) {
+        continue;
+      }
+      if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+        changes.push_back({DiaryChange::Kind::Year, it->second});
+        if (ev->mask & IN_IGNORED) {
+          year_by_wd_.erase(it);
+        }
+        continue;
+      }
+
+      int y = 0, m = 0, d = 0;
+      if ((ev->mask & IN_ISDIR) || !parse_diary_filename(name, y, m, d) ||
+          y != it->second) {
+        continue;
+      }
+      bool written = ev->mask & IN_CLOSE_WRITE;
+      if (appeared || vanished || written) {
+        changes.push_back(
+            {DiaryChange::Kind::Entry, y, m, d, appeared || written});
+      }
+    }
+  }
+}
+
+#else
+
+bool DiaryWatcher::start(const std::string &, Callback) { return false; }
+
+void DiaryWatcher::stop() {}
+
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A change in the diary tree reported by DiaryWatcher
+struct DiaryChange {
+  enum class Kind {
+    Entry, // a YYYY-MM-DD.md file appeared, disappeared or was written
+    Year,  // a year directory appeared or disappeared, rescan it
+    All,   // events were lost, rescan everything
+  };
+
+  Kind kind = Kind::Entry;
+  int year = 0;
+  int month = 0;
+  int day = 0;
+  bool present = false;
+};
+
+// Watches diary_dir and its year subdirectories with inotify and reports
+// created, deleted, renamed and rewritten entries, including those
+// written by other tools. Only available on Linux; start() returns false
+// elsewhere.
+class DiaryWatcher {
+public:
+  using Callback = std::function<void(std::vector<DiaryChange> changes)>;
+
+  DiaryWatcher() = default;
+  ~DiaryWatcher();
+
+  DiaryWatcher(const DiaryWatcher &) = delete;
+  DiaryWatcher &operator=(const DiaryWatcher &) = delete;
+
+  // Start watching on a background thread.
+  // on_changes is invoked from that thread with each batch of changes.
+  bool start(const std::string &diary_dir, Callback on_changes);
+
+  // Stop the background thread and release the watches
+  void stop();
+
+private:
+  void run();
+  void watch_year(int year);
+  void read_events(std::vector<DiaryChange> &changes);
+
+  std::string diary_dir_;
+  Callback on_changes_;
+  int inotify_fd_ = -1;
+  int wake_fd_ = -1;
+  int root_wd_ = -1;
+  std::map<int, int> year_by_wd_;
+  std::thread thread_;
+};
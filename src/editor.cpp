@@ -0,0 +1,152 @@
+#include "editor.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+bool split_command(std::string_view command, std::vector<std::string> &argv) {
+  argv.clear();
+  std::string word;
+  bool in_word = false;
+  for (std::size_t i = 0; i < command.size(); ++i) {
+    char c = command[i];
+    if (c == ' ' || c == '\t' || c == '\n') {
+      if (in_word) {
+        argv.push_back(std::move(word));
+        word.clear();
+        in_word = false;
+      }
+      continue;
+    }
+    in_word = true;
+    if (c == '\'') {
+      std::size_t end = command.find('\'', i + 1);
+      if (end == std::string_view::npos) {
+        return false;
+      }
+      word.append(command.substr(i + 1, end - i - 1));
+      i = end;
+    } else if (c == '"') {
+      // Inside double quotes a backslash only escapes what the shell
+      // would otherwise treat specially there
+      for (++i; i < command.size() && command[i] != '"'; ++i) {
+        if (command[i] == '\\' && i + 1 < command.size() &&
+            std::string_view("\"\\$`").find(command[i + 1]) !=
+                std::string_view::npos) {
+          ++i;
+        }
+        word.push_back(command[i]);
+      }
+      if (i == command.size()) {
+        return false;
+      }
+    } else if (c == '\\') {
+      if (++i == command.size()) {
+        return false;
+      }
+      word.push_back(command[i]);
+    } else {
+      word.push_back(c);
+    }
+  }
+  if (in_word) {
+    argv.push_back(std::move(word));
+  }
+  return true;
+}
+
+bool run_editor(const std::vector<std::string> &argv, const std::string &path,
+                bool quiet, std::string &error) {
+  if (argv.empty()) {
+    error = "No editor is configured.";
+    return false;
+  }
+  std::vector<char *> args;
+  for (const auto &arg : argv) {
+    args.push_back(const_cast<char *>(arg.c_str()));
+  }
+  args.push_back(const_cast<char *>(path.c_str()));
+  args.push_back(nullptr);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  if (quiet) {
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null",
+                                     O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+                                     O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null",
+                                     O_WRONLY, 0);
+  }
+
+  // The editor starts with default interrupt handling and nothing blocked,
+  // whatever the TUI had set up
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  sigset_t defaults, none;
+  sigemptyset(&defaults);
+  sigaddset(&defaults, SIGINT);
+  sigaddset(&defaults, SIGQUIT);
+  sigemptyset(&none);
+  posix_spawnattr_setsigdefault(&attr, &defaults);
+  posix_spawnattr_setsigmask(&attr, &none);
+  posix_spawnattr_setflags(&attr,
+                           POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+
+  // Like system(), let Ctrl-C and Ctrl-\ reach only the editor while it
+  // owns the terminal
+  struct sigaction ignore {}, old_int {}, old_quit {};
+  ignore.sa_handler = SIG_IGN;
+  sigemptyset(&ignore.sa_mask);
+  if (!quiet) {
+    sigaction(SIGINT, &ignore, &old_int);
+    sigaction(SIGQUIT, &ignore, &old_quit);
+  }
+
+  pid_t pid = 0;
+  int rc = posix_spawnp(&pid, args[0], &actions, &attr, args.data(), environ);
+  int status = 0;
+  int wait_error = 0;
+  if (rc == 0) {
+    while (waitpid(pid, &status, 0) < 0) {
+      if (errno != EINTR) {
+        wait_error = errno;
+        break;
+      }
+    }
+  }
+
+  if (!quiet) {
+    sigaction(SIGINT, &old_int, nullptr);
+    sigaction(SIGQUIT, &old_quit, nullptr);
+  }
+  posix_spawnattr_destroy(&attr);
+  posix_spawn_file_actions_destroy(&actions);
+
+  if (rc != 0) {
+    error = "Cannot run " + argv[0] + ": " + std::strerror(rc);
+    return false;
+  }
+  // Without the exit status there is no telling whether the editor saved
+  if (wait_error != 0) {
+    error = "Cannot wait for " + argv[0] + ": " + std::strerror(wait_error);
+    return false;
+  }
+  if (WIFSIGNALED(status)) {
+    error = argv[0] + " was killed by signal " +
+            std::to_string(WTERMSIG(status)) + ".";
+    return false;
+  }
+  if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+    error = argv[0] + " exited with status " +
+            std::to_string(WEXITSTATUS(status)) + ".";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Split a command line into arguments the way a POSIX shell splits words:
+// blanks separate arguments, single quotes keep their contents literally,
+// and backslashes and double quotes escape. Nothing is expanded. Returns
+// false on an unterminated quote or a trailing backslash.
+[[nodiscard]] bool split_command(std::string_view command,
+                                 std::vector<std::string> &argv);
+
+// Run argv with path as one more argument, looking argv[0] up on PATH,
+// and wait for it to exit. No shell is involved, so the path needs no
+// quoting. With quiet the child's stdin, stdout and stderr are /dev/null,
+// so a client handing the file to an editor server cannot draw over the
+// TUI. Returns false with a message for the status line in error if the
+// command could not be started, was killed or exited with non-zero status.
+[[nodiscard]] bool run_editor(const std::vector<std::string> &argv,
+                              const std::string &path, bool quiet,
+                              std::string &error);
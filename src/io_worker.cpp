@@ -0,0 +1,71 @@
+#include "io_worker.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Shared with the thread, so a detached worker never touches freed memory
+struct IoWorker::State {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<Job> jobs;
+  bool stopping = false;
+  Deliver deliver;
+};
+
+IoWorker::IoWorker(Deliver deliver) : state_(std::make_shared<State>()) {
+  state_->deliver = std::move(deliver);
+  std::thread(run, state_).detach();
+}
+
+IoWorker::~IoWorker() {
+  // Delivery happens under the mutex, so once stopping is set here no
+  // result can reach an owner that is going away
+  std::lock_guard lock(state_->mutex);
+  state_->stopping = true;
+  state_->jobs.clear();
+  state_->cv.notify_one();
+}
+
+void IoWorker::submit(Job job) {
+  {
+    std::lock_guard lock(state_->mutex);
+    state_->jobs.push_back(std::move(job));
+  }
+  state_->cv.notify_one();
+}
+
+IoWorker::Deliver IoWorker::partial() const {
+  return [state = state_](std::function<void()> apply) {
+    std::lock_guard lock(state->mutex);
+    if (!state->stopping) {
+      state->deliver(std::move(apply));
+    }
+  };
+}
+
+void IoWorker::run(std::shared_ptr<State> state) {
+  std::unique_lock lock(state->mutex);
+  while (true) {
+    state->cv.wait(lock,
+                   [&] { return state->stopping || !state->jobs.empty(); });
+    if (state->stopping) {
+      return;
+    }
+    Job job = std::move(state->jobs.front());
+    state->jobs.pop_front();
+
+    lock.unlock();
+    auto apply = job();
+    job = nullptr;
+    lock.lock();
+
+    if (state->stopping) {
+      return;
+    }
+    if (apply) {
+      state->deliver(std::move(apply));
+    }
+  }
+}
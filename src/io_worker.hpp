@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+// Runs filesystem work on one background thread, in submission order,
+// and hands each job's result back through a delivery function, normally
+// one that posts it to the UI thread. Results therefore arrive in the
+// order their jobs were submitted.
+//
+// A job that never returns, e.g. on a hung network mount, only stalls the
+// jobs queued behind it. The destructor does not wait for it: the thread
+// is detached, and nothing is delivered once the destructor has returned.
+class IoWorker {
+public:
+  // Receives each result on the worker thread and passes it on to the
+  // thread that owns the state it changes
+  using Deliver = std::function<void(std::function<void()> apply)>;
+  // Does the I/O and returns what applies its result, or an empty
+  // function when there is nothing to apply
+  using Job = std::function<std::function<void()>()>;
+
+  explicit IoWorker(Deliver deliver);
+  ~IoWorker();
+
+  IoWorker(const IoWorker &) = delete;
+  IoWorker &operator=(const IoWorker &) = delete;
+
+  void submit(Job job);
+
+  // Delivers a result right away, ahead of the running job's own, so a
+  // long job can show partial results. Safe to call from a job that
+  // outlives the worker; nothing is delivered then.
+  [[nodiscard]] Deliver partial() const;
+
+private:
+  struct State;
+  static void run(std::shared_ptr<State> state);
+
+  std::shared_ptr<State> state_;
+};
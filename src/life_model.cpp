@@ -0,0 +1,269 @@
+#include "life_model.hpp"
+#include "config.hpp"
+#include "date.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+
+namespace {
+using Words = std::vector<std::uint64_t>;
+
+// Mask of n bits starting at bit s of a word, s + n <= 64
+std::uint64_t word_mask(std::size_t s, std::size_t n) {
+  return (n == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << n) - 1) << s;
+}
+
+// Bits [first, first + count) of words, count <= 32
+std::uint32_t read_bits(const Words &words, std::size_t first, int count) {
+  std::size_t w = first / 64;
+  std::size_t s = first % 64;
+  std::uint64_t value = words[w] >> s;
+  if (s + count > 64) {
+    value |= words[w + 1] << (64 - s);
+  }
+  return static_cast<std::uint32_t>(value & word_mask(0, count));
+}
+
+// Overwrite bits [first, first + count) of words with value, count <= 32
+void write_bits(Words &words, std::size_t first, int count,
+                std::uint32_t value) {
+  std::size_t w = first / 64;
+  std::size_t s = first % 64;
+  std::uint64_t mask = word_mask(0, count);
+  std::uint64_t v = value & mask;
+  words[w] = (words[w] & ~(mask << s)) | (v << s);
+  if (s + count > 64) {
+    words[w + 1] = (words[w + 1] & ~(mask >> (64 - s))) | (v >> (64 - s));
+  }
+}
+
+// True if every bit in [first, last) is set, a word at a time
+bool all_bits(const Words &words, std::size_t first, std::size_t last) {
+  while (first < last) {
+    std::size_t s = first % 64;
+    std::size_t n = std::min<std::size_t>(64 - s, last - first);
+    std::uint64_t mask = word_mask(s, n);
+    if ((words[first / 64] & mask) != mask) {
+      return false;
+    }
+    first += n;
+  }
+  return true;
+}
+
+// The object behind shared, copied first unless this is its only owner
+template <typename T> T &own(std::shared_ptr<T> &shared) {
+  if (shared.use_count() > 1) {
+    shared = std::make_shared<T>(*shared);
+  } else {
+    // Pairs with the release by the last other owner letting go
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+  return *shared;
+}
+} // namespace
+
+LifeModel::LifeModel(const Config &config)
+    : diary_dir_(config.diary_dir), birth_year_(config.birth_year),
+      birth_month_(config.birth_month), death_year_(config.death_year),
+      death_month_(config.death_month) {}
+
+void LifeModel::build(int today_days) {
+  month_start_.assign(1, 0);
+  int y = birth_year_;
+  int m = birth_month_;
+  while (y < death_year_ || (y == death_year_ && m <= death_month_)) {
+    month_start_.push_back(month_start_.back() + days_in_month(y, m));
+    ++m;
+    if (m > 12) {
+      m = 1;
+      ++y;
+    }
+  }
+  const int months = month_count();
+  day_bits_.assign((month_start_.back() + 63) / 64, 0);
+  full_bits_.assign((months + 63) / 64, 0);
+  month_bytes_.assign(months, 0);
+
+  // Month i is over once month i + 1 starts on or before today
+  int today = today_days - days_from_epoch(birth_year_, birth_month_, 1);
+  past_months_ = static_cast<int>(
+      std::upper_bound(month_start_.begin() + 1, month_start_.end(), today) -
+      (month_start_.begin() + 1));
+  future_from_ = past_months_;
+  if (past_months_ < months && month_start_[past_months_] <= today) {
+    ++future_from_;
+  }
+  update_prefix_sums(0);
+}
+
+void LifeModel::refresh_diary_status(int today_days,
+                                     const DiaryIndex::Progress &progress) {
+  // Loaded off to the side, as snapshots taken by progress share what is
+  // published and must not see the load carry on
+  DiaryIndex index;
+  DiaryIndex::Progress publish;
+  if (progress) {
+    publish = [&](std::size_t done, std::size_t total) {
+      diary_index_ = std::make_shared<DiaryIndex>(index);
+      update_months(today_days);
+      progress(done, total);
+    };
+  }
+  if (index.load(diary_dir_, publish)) {
+    index.save(diary_dir_);
+  }
+  diary_index_ = std::make_shared<DiaryIndex>(std::move(index));
+
+  auto stats = std::make_shared<DiaryStats>();
+  if (stats->update(diary_dir_, *diary_index_)) {
+    stats->save(diary_dir_);
+  }
+  stats_ = std::move(stats);
+  unsaved_ = false;
+  update_months(today_days);
+}
+
+void LifeModel::refresh_day(int year, int month, int day, int today_days) {
+  own(diary_index_).update_entry(diary_dir_, year, month, day);
+  own(stats_).update_day(diary_dir_, year, month, day);
+  unsaved_ = true;
+  refresh_month(year, month, today_days);
+}
+
+void LifeModel::refresh_year(int year, int today_days) {
+  own(diary_index_).scan_year(diary_dir_, year);
+  own(stats_).update_year(diary_dir_, *diary_index_, year);
+  unsaved_ = true;
+  for (int m = 1; m <= 12; ++m) {
+    refresh_month(year, m, today_days);
+  }
+}
+
+void LifeModel::apply_changes(const std::vector<DiaryChange> &changes,
+                              int today_days) {
+  for (const auto &change : changes) {
+    switch (change.kind) {
+    case DiaryChange::Kind::Entry:
+      refresh_day(change.year, change.month, change.day, today_days);
+      break;
+    case DiaryChange::Kind::Year:
+      refresh_year(change.year, today_days);
+      break;
+    case DiaryChange::Kind::All:
+      refresh_diary_status(today_days);
+      return;
+    }
+  }
+}
+
+void LifeModel::save() {
+  if (!unsaved_) {
+    return;
+  }
+  diary_index_->save(diary_dir_);
+  stats_->save(diary_dir_);
+  unsaved_ = false;
+}
+
+int LifeModel::month_index(int year, int month) const {
+  int idx = (year - birth_year_) * 12 + (month - birth_month_);
+  if (idx < 0 || idx >= month_count()) {
+    return -1;
+  }
+  return idx;
+}
+
+int LifeModel::current_month_index() const {
+  return past_months_ < future_from_ ? past_months_ : 0;
+}
+
+MonthInfo LifeModel::month(int idx) const {
+  MonthInfo info;
+  int months_since = birth_month_ - 1 + idx;
+  info.year = birth_year_ + months_since / 12;
+  info.month = months_since % 12 + 1;
+  info.is_past = idx < past_months_;
+  info.is_current = idx >= past_months_ && idx < future_from_;
+  info.is_future = idx >= future_from_;
+  info.has_full_diary = (full_bits_[idx / 64] >> (idx % 64)) & 1;
+  info.entries = static_cast<int>(entry_prefix_[idx + 1] - entry_prefix_[idx]);
+  info.bytes = month_bytes_[idx];
+  return info;
+}
+
+bool LifeModel::has_diary(int idx, int day) const {
+  if (idx < 0 || idx >= month_count() || day < 1 ||
+      day > month_start_[idx + 1] - month_start_[idx]) {
+    return false;
+  }
+  std::size_t bit = month_start_[idx] + day - 1;
+  return (day_bits_[bit / 64] >> (bit % 64)) & 1;
+}
+
+LifeModel::MonthSpan LifeModel::span(int first, int last) const {
+  MonthSpan span;
+  span.has_past = first < past_months_;
+  span.has_current = past_months_ < future_from_ && first <= past_months_ &&
+                     past_months_ < last;
+  span.has_future = last > future_from_;
+  span.all_full = all_bits(full_bits_, first, last);
+  return span;
+}
+
+void LifeModel::update_months(int today_days) {
+  for (int idx = 0; idx < month_count(); ++idx) {
+    update_month(idx, today_days);
+  }
+  update_prefix_sums(0);
+}
+
+void LifeModel::update_month(int idx, int today_days) {
+  int months_since = birth_month_ - 1 + idx;
+  int year = birth_year_ + months_since / 12;
+  int month = months_since % 12 + 1;
+  int first = month_start_[idx];
+  int length = month_start_[idx + 1] - first;
+
+  std::uint32_t bits =
+      diary_index_->month_bits(year, month) & ((1u << length) - 1);
+  write_bits(day_bits_, first, length, bits);
+
+  bool full = std::popcount(bits) == length &&
+              days_from_epoch(year, month, length) <= today_days;
+  std::uint64_t full_bit = std::uint64_t{1} << (idx % 64);
+  full_bits_[idx / 64] =
+      full ? full_bits_[idx / 64] | full_bit : full_bits_[idx / 64] & ~full_bit;
+
+  month_bytes_[idx] = 0;
+  auto it = diary_index_->years().find(year);
+  if (it == diary_index_->years().end()) {
+    return;
+  }
+  const auto &rec = it->second;
+  for (; bits != 0; bits &= bits - 1) {
+    month_bytes_[idx] +=
+        rec.days[(month - 1) * 31 + std::countr_zero(bits)].size;
+  }
+}
+
+void LifeModel::update_prefix_sums(std::size_t from) {
+  entry_prefix_.resize(month_count() + 1);
+  byte_prefix_.resize(month_count() + 1);
+  for (std::size_t i = from; i + 1 < month_start_.size(); ++i) {
+    int length = month_start_[i + 1] - month_start_[i];
+    entry_prefix_[i + 1] =
+        entry_prefix_[i] +
+        std::popcount(read_bits(day_bits_, month_start_[i], length));
+    byte_prefix_[i + 1] = byte_prefix_[i] + month_bytes_[i];
+  }
+}
+
+void LifeModel::refresh_month(int year, int month, int today_days) {
+  int idx = month_index(year, month);
+  if (idx >= 0) {
+    update_month(idx, today_days);
+    update_prefix_sums(idx);
+  }
+}
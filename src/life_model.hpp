@@ -0,0 +1,141 @@
+#pragma once
+
+#include "diary_index.hpp"
+#include "diary_stats.hpp"
+#include "diary_watcher.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Config; // forward declare
+
+// One month of the life grid, as read from LifeModel::month()
+struct MonthInfo {
+  int year = 0;
+  int month = 0;
+  bool is_past = false;
+  bool is_current = false;
+  bool is_future = false;
+  bool has_full_diary = false;
+  // Entries written this month and their total size, from the index
+  int entries = 0;
+  std::int64_t bytes = 0;
+};
+
+// The months from birth to death and which of them have a diary entry for
+// every day. Holds no UI state, so it can be driven and measured without
+// a terminal, and copied off a background thread that keeps it current.
+//
+// Stored as flat arrays rather than one record per month: a bit per day
+// from the first day of the birth month to the last of the death month,
+// each month's offset into it, and a bit per month that is fully written.
+// Entry counts are popcounts of a month's slice, past and future follow
+// from where today falls, and a grid cell covering many months is summed
+// up a word at a time. A lifetime fits in a few kilobytes, and the diary
+// index and statistics behind it are shared between copies until one of
+// them changes.
+class LifeModel {
+public:
+  explicit LifeModel(const Config &config);
+
+  // Lay out the months from the birth month to the death month
+  void build(int today_days);
+
+  // Reload the diary index and the statistics cache, save them back if
+  // they changed, and recompute every month's full-diary flag. progress
+  // is called whenever another batch of rescanned years is reflected in
+  // month(); the statistics are only updated at the end.
+  void refresh_diary_status(int today_days,
+                            const DiaryIndex::Progress &progress = {});
+
+  // Re-stat one entry after it was created, edited or removed
+  void refresh_day(int year, int month, int day, int today_days);
+
+  // Rescan one year directory
+  void refresh_year(int year, int today_days);
+
+  // Apply changes reported by DiaryWatcher, rescanning only what they touch
+  void apply_changes(const std::vector<DiaryChange> &changes, int today_days);
+
+  // Write the diary index and the statistics cache back to diary_dir if
+  // entries were refreshed since they were last loaded or saved
+  void save();
+
+  // Index of the given month, -1 if it is out of range
+  [[nodiscard]] int month_index(int year, int month) const;
+
+  // Index of the month containing today, 0 if there is none
+  [[nodiscard]] int current_month_index() const;
+
+  // Number of months from the birth month to the death month
+  [[nodiscard]] int month_count() const {
+    return static_cast<int>(month_start_.size()) - 1;
+  }
+
+  // Month idx, 0 <= idx < month_count()
+  [[nodiscard]] MonthInfo month(int idx) const;
+
+  // True if day of month idx has an entry; a single bit test
+  [[nodiscard]] bool has_diary(int idx, int day) const;
+
+  // What a life grid cell covering months [first, last) is drawn from
+  struct MonthSpan {
+    bool has_past = false;
+    bool has_current = false;
+    bool has_future = false;
+    bool all_full = false; // every month of the span is fully written
+  };
+  [[nodiscard]] MonthSpan span(int first, int last) const;
+
+  // Entries and bytes written in months [first, last), in O(1) from
+  // prefix sums kept up to date with the index
+  [[nodiscard]] std::int64_t entries_between(int first, int last) const {
+    return entry_prefix_[last] - entry_prefix_[first];
+  }
+  [[nodiscard]] std::int64_t bytes_between(int first, int last) const {
+    return byte_prefix_[last] - byte_prefix_[first];
+  }
+
+  [[nodiscard]] const DiaryIndex &diary_index() const {
+    return *diary_index_;
+  }
+  [[nodiscard]] const DiaryStats &stats() const { return *stats_; }
+
+private:
+  void update_months(int today_days);
+  // Copy month idx's bits from the index and recompute its flag and size
+  void update_month(int idx, int today_days);
+  void update_prefix_sums(std::size_t from);
+  void refresh_month(int year, int month, int today_days);
+
+  std::string diary_dir_;
+  int birth_year_ = 0;
+  int birth_month_ = 0;
+  int death_year_ = 0;
+  int death_month_ = 0;
+
+  // Bit d is set when day d, counted from the first day of the birth
+  // month, has an entry
+  std::vector<std::uint64_t> day_bits_;
+  // Offset in day_bits_ of each month's first day, and one past the last
+  std::vector<std::int32_t> month_start_{0};
+  // Bit i is set when month i is over and has an entry every day
+  std::vector<std::uint64_t> full_bits_;
+  // Months entirely before today, and the first month entirely after it;
+  // they differ by one when today falls within the life span
+  int past_months_ = 0;
+  int future_from_ = 0;
+  // Size of each month's entries, from the index
+  std::vector<std::int64_t> month_bytes_;
+  // entry_prefix_[i] is the number of entries in months [0, i)
+  std::vector<std::int64_t> entry_prefix_{0};
+  std::vector<std::int64_t> byte_prefix_{0};
+  // Shared by copies of the model and copied before one of them changes
+  // them, so a copy costs a few kilobytes however long the index is
+  std::shared_ptr<DiaryIndex> diary_index_ = std::make_shared<DiaryIndex>();
+  std::shared_ptr<DiaryStats> stats_ = std::make_shared<DiaryStats>();
+  // Set by refresh_day() and refresh_year(), cleared when saved
+  bool unsaved_ = false;
+};
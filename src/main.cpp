@@ -1,24 +1,40 @@
 #include "calendar.hpp"
+#include "clock.hpp"
 #include "config.hpp"
+#include "daemon.hpp"
 #include "diary.hpp"
+#include "diary_index.hpp"
+#include "diary_stats.hpp"
+#include "diary_watcher.hpp"
+#include "profile.hpp"
+#include "range_query.hpp"
+#include "search_index.hpp"
+#include "status_watch.hpp"
+#include "ticker.hpp"
 
 #include <ftxui/component/component.hpp>
 #include <ftxui/component/screen_interactive.hpp>
 #include <ftxui/dom/elements.hpp>
 
-#include <atomic>
-#include <chrono>
 #include <iostream>
 #include <string>
-#include <thread>
 
 using namespace ftxui;
 
 int main(int argc, char *argv[]) {
   bool check_today = false;
   bool check_yesterday = false;
+  bool watch_today = false;
+  bool watch_yesterday = false;
   bool open_if_missing_today = false;
   bool open_if_missing_yesterday = false;
+  std::string search_query;
+  std::string range_query;
+  std::string range_format = "jsonl";
+  std::string profile_path;
+  bool daemon = false;
+  bool stats = false;
+  std::string client_query;
   std::string config_path;
 
   for (int i = 1; i < argc; ++i) {
@@ -29,22 +45,63 @@ int main(int argc, char *argv[]) {
                 << "  -h, --help                        Show this help message\n"
                 << "  --check-today                     Check if today's diary exists and exit\n"
                 << "  --check-yesterday                 Check if yesterday's diary exists and exit\n"
+                << "  --watch-today                     Print whether today's diary exists, again on every change\n"
+                << "  --watch-yesterday                 Print whether yesterday's diary exists, again on every change\n"
                 << "  --open-if-today-missing           Open TUI only if today's diary is missing\n"
-                << "  --open-if-yesterday-missing       Open TUI only if yesterday's diary is missing\n";
+                << "  --open-if-yesterday-missing       Open TUI only if yesterday's diary is missing\n"
+                << "  --search <terms>                  Print the dates whose diary contains all terms\n"
+                << "  --query FROM..TO                  Print presence, size and mtime of every day in the range\n"
+                << "  --format jsonl|csv                Output format of --query (default jsonl)\n"
+                << "  --stats                           Print streaks, coverage and totals\n"
+                << "  --profile[=<file>]                Show frame and I/O timings, write them as JSON on exit\n"
+                << "  --daemon                          Answer diary queries on a Unix socket\n"
+                << "  --client <query>                  Ask the running daemon: today, yesterday, streak, date YYYY-MM-DD\n";
       return 0;
     } else if (arg == "--check-today") {
       check_today = true;
     } else if (arg == "--check-yesterday") {
       check_yesterday = true;
+    } else if (arg == "--watch-today") {
+      watch_today = true;
+    } else if (arg == "--watch-yesterday") {
+      watch_yesterday = true;
     } else if (arg == "--open-if-today-missing") {
       open_if_missing_today = true;
     } else if (arg == "--open-if-yesterday-missing") {
       open_if_missing_yesterday = true;
+    } else if (arg == "--search" && i + 1 < argc) {
+      search_query = argv[++i];
+    } else if (arg == "--query" && i + 1 < argc) {
+      range_query = argv[++i];
+    } else if (arg == "--format" && i + 1 < argc) {
+      range_format = argv[++i];
+    } else if (arg == "--stats") {
+      stats = true;
+    } else if (arg == "--daemon") {
+      daemon = true;
+    } else if (arg == "--client" && i + 1 < argc) {
+      client_query = argv[++i];
+    } else if (arg == "--profile") {
+      profile_path = "life-calendar-profile.json";
+    } else if (arg.starts_with("--profile=")) {
+      profile_path = arg.substr(std::string("--profile=").size());
     } else if (config_path.empty() && arg[0] != '-') {
       config_path = arg;
     }
   }
 
+  // The client only talks to the daemon, so it skips config and time zones
+  if (!client_query.empty()) {
+    std::string reply;
+    std::string error;
+    if (!query_daemon(daemon_socket_path(), client_query, reply, error)) {
+      std::cerr << error << "\n";
+      return 2;
+    }
+    std::cout << reply << std::endl;
+    return reply.starts_with("error") ? 1 : 0;
+  }
+
   // Load config
   Config config;
   try {
@@ -54,6 +111,59 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
+  if (daemon) {
+    return DiaryDaemon(config).run(daemon_socket_path());
+  }
+
+  if (!search_query.empty()) {
+    SearchIndex index;
+    index.update(config.diary_dir);
+    for (const auto &match : index.search(search_query)) {
+      std::string path = get_diary_path(match.year, match.month, match.day,
+                                        config.diary_dir);
+      std::cout << format_date(match.year, match.month, match.day) << "  "
+                << SearchIndex::snippet(path, search_query) << "\n";
+    }
+    return 0;
+  }
+
+  if (!range_query.empty()) {
+    int from = 0, to = 0;
+    RangeFormat format;
+    if (!parse_date_range(range_query, from, to)) {
+      std::cerr << "Invalid range (expected YYYY-MM-DD..YYYY-MM-DD): "
+                << range_query << "\n";
+      return 1;
+    }
+    if (!parse_range_format(range_format, format)) {
+      std::cerr << "Unknown format (expected jsonl or csv): " << range_format
+                << "\n";
+      return 1;
+    }
+    DiaryIndex index;
+    if (index.load(config.diary_dir)) {
+      index.save(config.diary_dir);
+    }
+    return write_range_query(index, from, to, format, stdout) ? 0 : 1;
+  }
+
+  if (stats) {
+    DiaryIndex index;
+    if (index.load(config.diary_dir)) {
+      index.save(config.diary_dir);
+    }
+    DiaryStats diary_stats;
+    if (diary_stats.update(config.diary_dir, index)) {
+      diary_stats.save(config.diary_dir);
+    }
+    write_stats_report(index, diary_stats, local_today_days(), std::cout);
+    return 0;
+  }
+
+  if (watch_today || watch_yesterday) {
+    return watch_diary_status(config, watch_yesterday);
+  }
+
   if (check_today || check_yesterday) {
     int y, m, d;
     if (check_today) {
@@ -61,6 +171,7 @@ int main(int argc, char *argv[]) {
     } else {
       get_yesterday(y, m, d);
     }
+    // One stat; the index is only worth loading for more than one day
     bool exists = diary_exists(y, m, d, config.diary_dir);
     std::cout << (exists ? "true" : "false") << std::endl;
     return 0;
@@ -78,23 +189,80 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  if (!profile_path.empty()) {
+    profile::enable();
+  }
+
+  // Only the TUI creates entries, so only it needs a template file
+  install_diary_template(config);
+
   auto screen = ScreenInteractive::Fullscreen();
 
+  // Redraws the countdown on every wall-clock tick
+  Ticker ticker;
+
   CalendarHandle cal_handle;
 
   cal_handle = MakeLifeCalendarApp(config, [&](int year, int month, int day) {
+    profile::ScopedTimer timer(profile::Timer::EditorRoundTrip);
+    std::string error;
+
+    // Hand the entry to a running editor server without leaving the TUI,
+    // falling back to the local editor when none answers
+    if (!config.remote_editor.empty() &&
+        open_diary_remote(year, month, day, config.remote_editor,
+                          config.diary_dir, *config.entry_template, error)) {
+      cal_handle.RefreshDay(year, month, day);
+      return;
+    }
+    std::string remote_error =
+        config.remote_editor_error.empty() ? std::move(error)
+                                           : config.remote_editor_error;
+    if (!config.editor_error.empty()) {
+      cal_handle.SetStatusMessage(config.editor_error);
+      cal_handle.RefreshDay(year, month, day);
+      return;
+    }
+
     // Suspend the TUI, open the editor, then resume
+    bool ok = false;
     screen.WithRestoredIO([&] {
-      open_diary(year, month, day, config.editor, config.diary_dir,
-                 config.diary_template);
+      ticker.set_suspended(true);
+      ok = open_diary(year, month, day, config.editor, config.diary_dir,
+                      *config.entry_template, error);
+      ticker.set_suspended(false);
     })();
+    if (!ok) {
+      cal_handle.SetStatusMessage(error);
+    } else if (!remote_error.empty()) {
+      cal_handle.SetStatusMessage("Remote editor failed, used the local "
+                                  "editor: " + remote_error);
+    }
 
-    // After editor closes, refresh diary status markers
-    cal_handle.RefreshDiaryStatus();
+    // After editor closes, refresh the marker of the edited day
+    cal_handle.RefreshDay(year, month, day);
+  });
+
+  // Read the diary, previews and search results off the UI thread
+  cal_handle.SetIoPoster([&screen](std::function<void()> apply) {
+    screen.Post(std::move(apply));
+    screen.PostEvent(Event::Custom);
+  });
+
+  // Pick up entries created, removed or renamed by any other tool
+  DiaryWatcher watcher;
+  watcher.start(config.diary_dir, [&](std::vector<DiaryChange> changes) {
+    screen.Post([&cal_handle, changes = std::move(changes)] {
+      cal_handle.ApplyDiaryChanges(changes);
+    });
+    screen.PostEvent(Event::Custom);
   });
 
   // Wrap with CatchEvent for quit keys
   auto main_component = CatchEvent(cal_handle.component, [&](Event event) {
+    if (cal_handle.CapturesInput()) {
+      return false;
+    }
     if (event == Event::Character('q') || event == Event::Escape) {
       screen.Exit();
       return true;
@@ -102,20 +270,22 @@ int main(int argc, char *argv[]) {
     return false;
   });
 
-  std::atomic<bool> running{true};
-  std::thread ticker([&] {
-    using namespace std::chrono_literals;
-    while (running.load()) {
-      std::this_thread::sleep_for(1s);
-      screen.PostEvent(Event::Custom);
-    }
-  });
+  cal_handle.SetCountdownVisibilityCallback(
+      [&](bool visible) { ticker.set_visible(visible); });
+  ticker.start(config.tick_rate, [&] { screen.PostEvent(Event::Custom); });
 
   screen.Loop(main_component);
 
-  running.store(false);
-  if (ticker.joinable()) {
-    ticker.join();
+  ticker.stop();
+  watcher.stop();
+  cal_handle.SaveModel();
+
+  if (!profile_path.empty()) {
+    if (profile::write_json(profile_path)) {
+      std::cerr << "Profile written to " << profile_path << "\n";
+    } else {
+      std::cerr << "Could not write profile to " << profile_path << "\n";
+    }
   }
 
   return 0;
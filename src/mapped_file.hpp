@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string &path) { open(path); }
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  // Map the file, returning false if it cannot be opened.
+  // An empty file opens successfully with size() == 0.
+  bool open(const std::string &path);
+  void close();
+
+  [[nodiscard]] bool is_open() const { return open_; }
+  [[nodiscard]] const char *data() const { return data_; }
+  [[nodiscard]] std::size_t size() const { return size_; }
+  [[nodiscard]] std::string_view view() const { return {data_, size_}; }
+
+private:
+  const char *data_ = nullptr;
+  std::size_t size_ = 0;
+  bool open_ = false;
+};
@@ -0,0 +1,82 @@
+#include "preview_cache.hpp"
+
+PreviewCache::PreviewCache(std::size_t capacity)
+    : capacity_(capacity == 0 ? 1 : capacity) {}
+
+PreviewDocument &PreviewCache::get(const std::string &path) {
+  Entry &entry = find_or_add(path);
+  if (!entry.loaded || entry.stale) {
+    entry.current = load(path, entry.current);
+    entry.loaded = true;
+    entry.stale = false;
+    entry.pending = false;
+  }
+  return *entry.current.document;
+}
+
+PreviewDocument *PreviewCache::peek(const std::string &path, bool &reload,
+                                    Loaded &previous) {
+  Entry &entry = find_or_add(path);
+  reload = (!entry.loaded || entry.stale) && !entry.pending;
+  if (reload) {
+    // An invalidation arriving while this load runs sets stale again and
+    // forces one more
+    entry.stale = false;
+    entry.pending = true;
+    previous = entry.current;
+  }
+  return entry.loaded ? entry.current.document.get() : nullptr;
+}
+
+PreviewCache::Loaded PreviewCache::load(const std::string &path,
+                                        const Loaded &previous,
+                                        std::size_t lines) {
+  Loaded loaded;
+  loaded.exists = stat_file(path, loaded.stat);
+  if (previous.document && loaded.exists == previous.exists &&
+      loaded.stat == previous.stat) {
+    return previous;
+  }
+  loaded.document = std::make_shared<PreviewDocument>();
+  if (loaded.exists && loaded.document->open(path) && lines > 0) {
+    loaded.document->has_line(lines - 1);
+  }
+  return loaded;
+}
+
+void PreviewCache::store(const std::string &path, Loaded loaded) {
+  Entry &entry = find_or_add(path);
+  entry.current = std::move(loaded);
+  entry.loaded = true;
+  entry.pending = false;
+}
+
+void PreviewCache::invalidate(const std::string &path) {
+  auto it = by_path_.find(path);
+  if (it != by_path_.end()) {
+    it->second->stale = true;
+  }
+}
+
+void PreviewCache::invalidate_all() {
+  for (auto &entry : entries_) {
+    entry.stale = true;
+  }
+}
+
+PreviewCache::Entry &PreviewCache::find_or_add(const std::string &path) {
+  auto it = by_path_.find(path);
+  if (it != by_path_.end()) {
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return entries_.front();
+  }
+
+  if (entries_.size() >= capacity_) {
+    by_path_.erase(entries_.back().path);
+    entries_.pop_back();
+  }
+  entries_.emplace_front();
+  by_path_[path] = entries_.begin();
+  entries_.front().path = path;
+  return entries_.front();
+}
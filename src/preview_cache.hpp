@@ -0,0 +1,74 @@
+#pragma once
+
+#include "diary.hpp"
+#include "preview_document.hpp"
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Bounded LRU cache of opened diary previews keyed by path.
+// Each entry remembers the file's mtime and size from when it was opened.
+// Fresh entries are served without touching the filesystem; an entry
+// marked stale by invalidate() costs one stat and is reopened only when
+// the mtime or size actually changed.
+//
+// The filesystem half, load(), is static and can run on another thread:
+// peek() says what to load without doing any I/O and store() installs
+// the result. get() does all three in one call.
+class PreviewCache {
+public:
+  // A file as loaded: whether it exists, its stat, and the opened document
+  struct Loaded {
+    bool exists = false;
+    FileStat stat;
+    std::shared_ptr<PreviewDocument> document;
+  };
+
+  explicit PreviewCache(std::size_t capacity = 64);
+
+  // The opened file, with no lines when it does not exist. Lines are
+  // indexed lazily as they are read, hence not const.
+  PreviewDocument &get(const std::string &path);
+
+  // The document last stored for path, nullptr before the first load.
+  // When the entry is missing or stale and no load is pending yet, sets
+  // reload, fills previous with what to pass to load() and marks a load
+  // pending.
+  PreviewDocument *peek(const std::string &path, bool &reload,
+                        Loaded &previous);
+
+  // Stat path and reopen it unless it still matches previous. The first
+  // lines lines are indexed before returning; the rest are left for
+  // whoever scrolls to them, so a cached note holds no more of its file
+  // than has been shown.
+  [[nodiscard]] static Loaded load(const std::string &path,
+                                   const Loaded &previous,
+                                   std::size_t lines = 0);
+
+  // Install the result of load()
+  void store(const std::string &path, Loaded loaded);
+
+  // Re-validate the entry for path on its next lookup
+  void invalidate(const std::string &path);
+
+  // Re-validate every entry on its next lookup
+  void invalidate_all();
+
+private:
+  struct Entry {
+    std::string path;
+    bool loaded = false;
+    bool stale = false;
+    bool pending = false;
+    Loaded current;
+  };
+
+  Entry &find_or_add(const std::string &path);
+
+  std::size_t capacity_;
+  std::list<Entry> entries_; // most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> by_path_;
+};
@@ -0,0 +1,251 @@
+#include "preview_document.hpp"
+#include "profile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr int kTabWidth = 4;
+constexpr std::string_view kReplacement = "\xEF\xBF\xBD"; // U+FFFD
+constexpr std::string_view kEllipsis = "...";
+
+struct Range {
+  char32_t first;
+  char32_t last;
+};
+
+// Combining marks, zero-width spaces and joiners, variation selectors
+constexpr Range kZeroWidth[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x0610, 0x061A},
+    {0x064B, 0x065F}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E},
+    {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x2028, 0x202E},
+    {0x2060, 0x2064}, {0x20D0, 0x20FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F},
+    {0xFEFF, 0xFEFF}, {0xE0100, 0xE01EF},
+};
+
+// East Asian wide and fullwidth characters and emoji
+constexpr Range kWide[] = {
+    {0x1100, 0x115F},   {0x231A, 0x231B},   {0x2329, 0x232A},
+    {0x23E9, 0x23EC},   {0x23F0, 0x23F3},   {0x25FD, 0x25FE},
+    {0x2614, 0x2615},   {0x2648, 0x2653},   {0x26A1, 0x26A1},
+    {0x26AA, 0x26AB},   {0x26BD, 0x26BE},   {0x26C4, 0x26C5},
+    {0x26D4, 0x26D4},   {0x26EA, 0x26EA},   {0x26F2, 0x26F5},
+    {0x26FA, 0x26FD},   {0x2705, 0x2705},   {0x270A, 0x270B},
+    {0x2728, 0x2728},   {0x274C, 0x274C},   {0x2753, 0x2755},
+    {0x2757, 0x2757},   {0x2795, 0x2797},   {0x27B0, 0x27B0},
+    {0x2B1B, 0x2B1C},   {0x2B50, 0x2B50},   {0x2E80, 0x303E},
+    {0x3041, 0x33FF},   {0x3400, 0x4DBF},   {0x4E00, 0x9FFF},
+    {0xA000, 0xA4CF},   {0xA960, 0xA97F},   {0xAC00, 0xD7A3},
+    {0xF900, 0xFAFF},   {0xFE10, 0xFE19},   {0xFE30, 0xFE6F},
+    {0xFF00, 0xFF60},   {0xFFE0, 0xFFE6},   {0x1F004, 0x1F004},
+    {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A},
+    {0x1F200, 0x1F251}, {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF},
+    {0x1F7E0, 0x1F7EB}, {0x1F900, 0x1F9FF}, {0x1FA70, 0x1FAFF},
+    {0x20000, 0x3FFFD},
+};
+
+template <std::size_t N>
+bool in_ranges(const Range (&ranges)[N], char32_t c) {
+  auto it = std::upper_bound(
+      std::begin(ranges), std::end(ranges), c,
+      [](char32_t value, const Range &r) { return value < r.first; });
+  return it != std::begin(ranges) && c <= std::prev(it)->last;
+}
+
+// Decode the UTF-8 sequence at the start of s into c, returning its
+// length, or 0 if it is malformed, overlong or a surrogate
+std::size_t decode_utf8(std::string_view s, char32_t &c) {
+  auto b0 = static_cast<unsigned char>(s[0]);
+  std::size_t len = 0;
+  char32_t min = 0;
+  if (b0 < 0x80) {
+    c = b0;
+    return 1;
+  } else if ((b0 & 0xE0) == 0xC0) {
+    len = 2, min = 0x80, c = b0 & 0x1F;
+  } else if ((b0 & 0xF0) == 0xE0) {
+    len = 3, min = 0x800, c = b0 & 0x0F;
+  } else if ((b0 & 0xF8) == 0xF0) {
+    len = 4, min = 0x10000, c = b0 & 0x07;
+  } else {
+    return 0;
+  }
+  if (s.size() < len) {
+    return 0;
+  }
+  for (std::size_t i = 1; i < len; ++i) {
+    auto b = static_cast<unsigned char>(s[i]);
+    if ((b & 0xC0) != 0x80) {
+      return 0;
+    }
+    c = (c << 6) | (b & 0x3F);
+  }
+  if (c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+    return 0;
+  }
+  return len;
+}
+} // namespace
+
+PreviewDocument::~PreviewDocument() { close(); }
+
+bool PreviewDocument::open(const std::string &path) {
+  close();
+  profile::count_open();
+  fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st{};
+  if (fd_ < 0 || ::fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close();
+    return false;
+  }
+  read_more();
+  done_ = text_.empty();
+  if (!done_) {
+    starts_.push_back(0);
+  }
+  return true;
+}
+
+void PreviewDocument::close() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+  fd_ = -1;
+  data_.clear();
+  text_ = {};
+  starts_.clear();
+  scanned_ = 0;
+  done_ = true;
+}
+
+bool PreviewDocument::read_more() {
+  if (fd_ < 0) {
+    return false;
+  }
+  std::size_t size = data_.size();
+  data_.resize(size + kChunk);
+  ssize_t n = 0;
+  do {
+    n = ::pread(fd_, data_.data() + size, kChunk, static_cast<off_t>(size));
+  } while (n < 0 && errno == EINTR);
+  data_.resize(size + static_cast<std::size_t>(std::max<ssize_t>(n, 0)));
+  text_ = data_;
+  if (n <= 0) {
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  profile::count_bytes_read(static_cast<std::uint64_t>(n));
+  return true;
+}
+
+bool PreviewDocument::index_through(std::size_t i) {
+  while (starts_.size() <= i && !done_) {
+    const void *newline = std::memchr(text_.data() + scanned_, '\n',
+                                      text_.size() - scanned_);
+    if (!newline) {
+      // The rest of the line may not have been read yet
+      std::size_t searched = text_.size();
+      if (read_more()) {
+        scanned_ = searched;
+        continue;
+      }
+      done_ = true;
+      break;
+    }
+    scanned_ = static_cast<const char *>(newline) - text_.data() + 1;
+    if (scanned_ < text_.size() || read_more()) {
+      starts_.push_back(scanned_);
+    } else {
+      done_ = true;
+    }
+  }
+  return i < starts_.size();
+}
+
+bool PreviewDocument::line(std::size_t i, std::string_view &out) {
+  if (!index_through(i)) {
+    return false;
+  }
+  std::size_t begin = starts_[i];
+  std::size_t end = index_through(i + 1) ? starts_[i + 1] - 1 : text_.size();
+  if (end > begin && text_[end - 1] == '\n') {
+    --end;
+  }
+  if (end > begin && text_[end - 1] == '\r') {
+    --end;
+  }
+  out = text_.substr(begin, end - begin);
+  return true;
+}
+
+std::size_t PreviewDocument::line_count() {
+  index_through(std::numeric_limits<std::size_t>::max());
+  return starts_.size();
+}
+
+int codepoint_width(char32_t c) {
+  if (c < 0x300) {
+    return 1;
+  }
+  if (in_ranges(kZeroWidth, c)) {
+    return 0;
+  }
+  return c >= 0x1100 && in_ranges(kWide, c) ? 2 : 1;
+}
+
+std::string fit_to_width(std::string_view line, int width) {
+  width = std::max(width, 0);
+  std::string out;
+  out.reserve(std::min<std::size_t>(line.size(), width * 4));
+
+  int columns = 0;
+  // Length of out while there was still room for the ellipsis after it
+  std::size_t cut = 0;
+  auto append = [&](std::string_view bytes, int w) {
+    if (columns + w > width) {
+      return false;
+    }
+    out.append(bytes);
+    columns += w;
+    if (columns <= width - static_cast<int>(kEllipsis.size())) {
+      cut = out.size();
+    }
+    return true;
+  };
+
+  for (std::size_t i = 0; i < line.size();) {
+    char32_t c = 0;
+    std::size_t len = decode_utf8(line.substr(i), c);
+    bool fits = true;
+    if (len == 0) {
+      fits = append(kReplacement, 1);
+      len = 1;
+    } else if (c == '\t') {
+      int spaces = kTabWidth - columns % kTabWidth;
+      for (int s = 0; s < spaces && fits; ++s) {
+        fits = append(" ", 1);
+      }
+    } else if (c < 0x20 || (c >= 0x7F && c < 0xA0)) {
+      fits = append(" ", 1);
+    } else {
+      fits = append(line.substr(i, len), codepoint_width(c));
+    }
+    if (!fits) {
+      if (width < static_cast<int>(kEllipsis.size())) {
+        return std::string(width, '.');
+      }
+      out.resize(cut);
+      out.append(kEllipsis);
+      return out;
+    }
+    i += len;
+  }
+  return out;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A diary entry opened for previewing. Line starts are found with memchr
+// only as far as lines are asked for, and a large file is read only that
+// far, a chunk at a time, so the first screen of a multi-megabyte entry
+// costs the same as that of a short one.
+//
+// The file is read into memory rather than mapped: a mapping of a file
+// that another tool truncates in place faults on the next read and kills
+// the process, while a read just comes up short and the document ends
+// there.
+class PreviewDocument {
+public:
+  // Read at open, and then at a time as further lines are asked for
+  static constexpr std::size_t kChunk = 256 * 1024;
+
+  PreviewDocument() = default;
+  ~PreviewDocument();
+  // Not copyable or movable: text_ points into data_
+  PreviewDocument(const PreviewDocument &) = delete;
+  PreviewDocument &operator=(const PreviewDocument &) = delete;
+
+  // Open path, returning false if it cannot be read
+  bool open(const std::string &path);
+  void close();
+
+  // Line i without its line ending; false past the last line. out stays
+  // valid until the next call that may read more of the file.
+  bool line(std::size_t i, std::string_view &out);
+
+  // True if line i exists, indexing only as far as needed
+  bool has_line(std::size_t i) { return index_through(i); }
+
+  // Number of lines, indexing the rest of the file
+  std::size_t line_count();
+
+  // Lines known so far, and whether that is all of them
+  [[nodiscard]] std::size_t lines_indexed() const { return starts_.size(); }
+  [[nodiscard]] bool fully_indexed() const { return done_; }
+
+private:
+  bool index_through(std::size_t i);
+  // Append up to kChunk more bytes of the file; false at its end
+  bool read_more();
+
+  int fd_ = -1; // open until the whole file has been read
+  std::string data_;
+  std::string_view text_;
+  std::vector<std::size_t> starts_; // offset of each line found so far
+  std::size_t scanned_ = 0;         // offset the next search starts at
+  bool done_ = true;
+};
+
+// Terminal columns taken by a code point: 0 for combining marks and
+// zero-width characters, 2 for East Asian wide characters and emoji
+[[nodiscard]] int codepoint_width(char32_t c);
+
+// The line as it fits in width terminal columns. Multi-byte UTF-8
+// sequences are never split, invalid bytes become U+FFFD, tabs are
+// expanded and other control characters shown as spaces. A line that
+// does not fit ends in "..." within width.
+[[nodiscard]] std::string fit_to_width(std::string_view line, int width);
@@ -0,0 +1,198 @@
+#include "profile.hpp"
+#include "diary.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace profile {
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Samples kept per timer for the p99
+constexpr std::size_t kWindow = 1024;
+
+constexpr const char *kTimerNames[] = {
+    "frame", "event_to_frame", "refresh_diary_status", "editor_round_trip",
+    "clock_snapshot"};
+static_assert(std::size(kTimerNames) == std::size_t(Timer::Count));
+
+struct Series {
+  std::uint64_t count = 0;
+  double total_ms = 0;
+  double last_ms = 0;
+  double max_ms = 0;
+  std::vector<double> window; // ring buffer of the latest samples
+};
+
+std::atomic<bool> g_enabled{false};
+std::atomic<std::uint64_t> g_stats{0};
+std::atomic<std::uint64_t> g_opens{0};
+std::atomic<std::uint64_t> g_bytes_read{0};
+
+std::mutex g_mutex;
+std::array<Series, std::size_t(Timer::Count)> g_series;
+Clock::time_point g_frame_start;
+Clock::time_point g_pending_event;
+FsCounters g_frame_base;
+FsCounters g_last_frame;
+
+double to_ms(Clock::duration d) {
+  return std::chrono::duration<double, std::milli>(d).count();
+}
+
+FsCounters operator-(const FsCounters &a, const FsCounters &b) {
+  return {a.stats - b.stats, a.opens - b.opens, a.bytes_read - b.bytes_read};
+}
+
+std::string fs_json(const FsCounters &c) {
+  return "{\"stats\": " + std::to_string(c.stats) +
+         ", \"opens\": " + std::to_string(c.opens) +
+         ", \"bytes_read\": " + std::to_string(c.bytes_read) + "}";
+}
+} // namespace
+
+void enable() { g_enabled.store(true, std::memory_order_relaxed); }
+
+bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+void count_stat() {
+  if (enabled()) {
+    g_stats.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void count_open() {
+  if (enabled()) {
+    g_opens.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void count_bytes_read(std::uint64_t bytes) {
+  if (enabled()) {
+    g_bytes_read.fetch_add(bytes, std::memory_order_relaxed);
+  }
+}
+
+void record(Timer timer, Clock::duration elapsed) {
+  if (!enabled()) {
+    return;
+  }
+  double ms = to_ms(elapsed);
+  std::lock_guard lock(g_mutex);
+  auto &s = g_series[std::size_t(timer)];
+  if (s.window.size() < kWindow) {
+    s.window.push_back(ms);
+  } else {
+    s.window[s.count % kWindow] = ms;
+  }
+  ++s.count;
+  s.total_ms += ms;
+  s.last_ms = ms;
+  s.max_ms = std::max(s.max_ms, ms);
+}
+
+void mark_event() {
+  if (!enabled()) {
+    return;
+  }
+  std::lock_guard lock(g_mutex);
+  // Latency counts from the oldest event the next frame answers
+  if (g_pending_event == Clock::time_point{}) {
+    g_pending_event = Clock::now();
+  }
+}
+
+void frame_begin() {
+  if (enabled()) {
+    g_frame_start = Clock::now();
+  }
+}
+
+void frame_end() {
+  if (!enabled() || g_frame_start == Clock::time_point{}) {
+    return;
+  }
+  auto now = Clock::now();
+  record(Timer::Frame, now - g_frame_start);
+  g_frame_start = {};
+
+  Clock::time_point event;
+  {
+    std::lock_guard lock(g_mutex);
+    event = std::exchange(g_pending_event, Clock::time_point{});
+    auto total = fs_total();
+    g_last_frame = total - g_frame_base;
+    g_frame_base = total;
+  }
+  if (event != Clock::time_point{}) {
+    record(Timer::EventToFrame, now - event);
+  }
+}
+
+TimerStats stats(Timer timer) {
+  std::lock_guard lock(g_mutex);
+  const auto &s = g_series[std::size_t(timer)];
+  TimerStats out;
+  out.count = s.count;
+  out.last_ms = s.last_ms;
+  out.max_ms = s.max_ms;
+  if (s.count > 0) {
+    out.avg_ms = s.total_ms / double(s.count);
+    auto sorted = s.window;
+    auto idx = std::min(sorted.size() - 1, sorted.size() * 99 / 100);
+    std::nth_element(sorted.begin(), sorted.begin() + idx, sorted.end());
+    out.p99_ms = sorted[idx];
+  }
+  return out;
+}
+
+FsCounters fs_last_frame() {
+  std::lock_guard lock(g_mutex);
+  return g_last_frame;
+}
+
+FsCounters fs_total() {
+  return {g_stats.load(std::memory_order_relaxed),
+          g_opens.load(std::memory_order_relaxed),
+          g_bytes_read.load(std::memory_order_relaxed)};
+}
+
+std::string to_json() {
+  std::string out = "{\n  \"timers_ms\": {\n";
+  char buf[256];
+  for (std::size_t i = 0; i < std::size_t(Timer::Count); ++i) {
+    auto s = stats(Timer(i));
+    std::snprintf(buf, sizeof(buf),
+                  "    \"%s\": {\"count\": %llu, \"last\": %.3f, "
+                  "\"avg\": %.3f, \"p99\": %.3f, \"max\": %.3f}%s\n",
+                  kTimerNames[i], static_cast<unsigned long long>(s.count),
+                  s.last_ms, s.avg_ms, s.p99_ms, s.max_ms,
+                  i + 1 < std::size_t(Timer::Count) ? "," : "");
+    out += buf;
+  }
+
+  auto total = fs_total();
+  auto frames = std::max<std::uint64_t>(1, stats(Timer::Frame).count);
+  out += "  },\n  \"fs\": {\n";
+  out += "    \"total\": " + fs_json(total) + ",\n";
+  out += "    \"last_frame\": " + fs_json(fs_last_frame()) + ",\n";
+  std::snprintf(buf, sizeof(buf),
+                "    \"per_frame\": {\"stats\": %.2f, \"opens\": %.2f, "
+                "\"bytes_read\": %.1f}\n  }\n}\n",
+                double(total.stats) / double(frames),
+                double(total.opens) / double(frames),
+                double(total.bytes_read) / double(frames));
+  out += buf;
+  return out;
+}
+
+bool write_json(const std::string &path) {
+  return write_file_atomically(path, to_json());
+}
+
+} // namespace profile
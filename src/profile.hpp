@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Counters and timings behind --profile.
+// The hooks stay in the normal build and return after one relaxed atomic
+// load until profiling is enabled. Filesystem counters are atomics
+// because directory scans run on the thread pool.
+namespace profile {
+
+enum class Timer {
+  Frame,              // building, laying out and drawing one frame
+  EventToFrame,       // from an input event to the end of the next frame
+  RefreshDiaryStatus, // full diary rescan
+  EditorRoundTrip,    // leaving the TUI for the editor and coming back
+  ClockSnapshot,      // reading the clock and converting it to local time
+  Count
+};
+
+struct TimerStats {
+  std::uint64_t count = 0;
+  double last_ms = 0;
+  double avg_ms = 0;
+  double p99_ms = 0; // over the most recent samples
+  double max_ms = 0;
+};
+
+struct FsCounters {
+  std::uint64_t stats = 0;
+  std::uint64_t opens = 0; // files and directory listings
+  std::uint64_t bytes_read = 0;
+};
+
+void enable();
+[[nodiscard]] bool enabled();
+
+void count_stat();
+void count_open();
+void count_bytes_read(std::uint64_t bytes);
+
+void record(Timer timer, std::chrono::steady_clock::duration elapsed);
+
+// Record the lifetime of the object under a timer
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Timer timer) : timer_(timer) {
+    if (enabled()) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+  ~ScopedTimer() {
+    if (start_ != std::chrono::steady_clock::time_point{}) {
+      record(timer_, std::chrono::steady_clock::now() - start_);
+    }
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  Timer timer_;
+  std::chrono::steady_clock::time_point start_{};
+};
+
+// An input event arrived; the next frame_end() records its latency
+void mark_event();
+
+// Bracket one frame, on the UI thread. frame_end() also closes the
+// filesystem counters of the frame.
+void frame_begin();
+void frame_end();
+
+[[nodiscard]] TimerStats stats(Timer timer);
+
+// Filesystem calls since the previous frame ended, and since startup
+[[nodiscard]] FsCounters fs_last_frame();
+[[nodiscard]] FsCounters fs_total();
+
+// Every counter as a JSON object
+[[nodiscard]] std::string to_json();
+
+bool write_json(const std::string &path);
+
+} // namespace profile
@@ -0,0 +1,128 @@
+#include "range_query.hpp"
+#include "config.hpp"
+#include "date.hpp"
+
+#include <charconv>
+#include <string>
+
+namespace {
+// Output is handed to stdio in chunks of about this size
+constexpr std::size_t kChunkSize = 64 * 1024;
+
+bool parse_day(std::string_view s, int &days) {
+  int y = 0, m = 0, d = 0;
+  if (!parse_date(s, y, m, d) || y < 0 || d > days_in_month(y, m)) {
+    return false;
+  }
+  days = days_from_epoch(y, m, d);
+  return true;
+}
+
+void append_number(std::string &out, std::int64_t value) {
+  char buf[24];
+  auto res = std::to_chars(buf, buf + sizeof(buf), value);
+  out.append(buf, res.ptr);
+}
+
+void append_two_digits(std::string &out, int value) {
+  out.push_back(char('0' + value / 10));
+  out.push_back(char('0' + value % 10));
+}
+
+// YYYY-MM-DD without going through a stream for every row
+void append_date(std::string &out, int y, int m, int d) {
+  if (y < 1000) {
+    out.append(y < 10 ? "000" : y < 100 ? "00" : "0");
+  }
+  append_number(out, y);
+  out.push_back('-');
+  append_two_digits(out, m);
+  out.push_back('-');
+  append_two_digits(out, d);
+}
+
+void append_row(std::string &out, RangeFormat format, int y, int m, int d,
+                bool exists, const FileStat &stat) {
+  if (format == RangeFormat::Csv) {
+    append_date(out, y, m, d);
+    out.append(exists ? ",true," : ",false,");
+    if (exists) {
+      append_number(out, stat.size);
+      out.push_back(',');
+      append_number(out, stat.mtime_ns);
+    } else {
+      out.push_back(',');
+    }
+    out.push_back('\n');
+    return;
+  }
+
+  out.append("{\"date\":\"");
+  append_date(out, y, m, d);
+  if (!exists) {
+    out.append("\",\"exists\":false,\"size\":null,\"mtime_ns\":null}\n");
+    return;
+  }
+  out.append("\",\"exists\":true,\"size\":");
+  append_number(out, stat.size);
+  out.append(",\"mtime_ns\":");
+  append_number(out, stat.mtime_ns);
+  out.append("}\n");
+}
+
+bool flush(std::string &buffer, std::FILE *out) {
+  bool ok = std::fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+  buffer.clear();
+  return ok;
+}
+} // namespace
+
+bool parse_date_range(std::string_view s, int &from_days, int &to_days) {
+  auto sep = s.find("..");
+  return sep != std::string_view::npos &&
+         parse_day(s.substr(0, sep), from_days) &&
+         parse_day(s.substr(sep + 2), to_days) && from_days <= to_days;
+}
+
+bool parse_range_format(std::string_view s, RangeFormat &out) {
+  if (s == "jsonl") {
+    out = RangeFormat::JsonLines;
+  } else if (s == "csv") {
+    out = RangeFormat::Csv;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool write_range_query(const DiaryIndex &index, int from_days, int to_days,
+                       RangeFormat format, std::FILE *out) {
+  std::string buffer;
+  buffer.reserve(kChunkSize + 128);
+  if (format == RangeFormat::Csv) {
+    buffer.append("date,exists,size,mtime_ns\n");
+  }
+
+  // Walk the calendar directly instead of converting every day count
+  int y = 0, m = 0, d = 0;
+  date_from_epoch(from_days, y, m, d);
+  int month_length = days_in_month(y, m);
+  for (int days = from_days; days <= to_days; ++days) {
+    FileStat stat;
+    bool exists = index.entry_stat(y, m, d, stat);
+    append_row(buffer, format, y, m, d, exists, stat);
+    if (buffer.size() >= kChunkSize && !flush(buffer, out)) {
+      return false;
+    }
+
+    if (++d > month_length) {
+      d = 1;
+      if (++m > 12) {
+        m = 1;
+        ++y;
+      }
+      month_length = days_in_month(y, m);
+    }
+  }
+  return flush(buffer, out) && std::fflush(out) == 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "diary_index.hpp"
+
+#include <cstdio>
+#include <string_view>
+
+// Output formats of --query
+enum class RangeFormat { JsonLines, Csv };
+
+// Parse an inclusive range "YYYY-MM-DD..YYYY-MM-DD" into day counts since
+// 1970-01-01. Fails on invalid dates and when the range runs backwards.
+[[nodiscard]] bool parse_date_range(std::string_view s, int &from_days,
+                                    int &to_days);
+
+// Parse a format name: "jsonl" or "csv"
+[[nodiscard]] bool parse_range_format(std::string_view s, RangeFormat &out);
+
+// Write one line per day of [from_days, to_days] with whether it has an
+// entry and the entry's size and mtime in nanoseconds, all looked up in
+// the index. CSV output starts with a header line. Output is written in
+// large chunks as it is produced, so long ranges stream in constant
+// memory. Returns false if writing failed.
+bool write_range_query(const DiaryIndex &index, int from_days, int to_days,
+                       RangeFormat format, std::FILE *out);
@@ -0,0 +1,407 @@
+#include "search_index.hpp"
+#include "mapped_file.hpp"
+#include "preview_document.hpp"
+#include "profile.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr char kMagic[8] = {'L', 'C', 'S', 'R', 'C', 'H', '\0', '\0'};
+constexpr std::uint32_t kVersion = 2;
+constexpr std::size_t kMaxTermLength = 64;
+
+// Length of the UTF-8 sequence at text[i] and its code point; a stray or
+// truncated byte is taken on its own as U+FFFD
+std::size_t decode_utf8(std::string_view text, std::size_t i,
+                        char32_t &code) {
+  unsigned char c = text[i];
+  std::size_t length = c < 0x80   ? 1
+                       : c < 0xC2 ? 0
+                       : c < 0xE0 ? 2
+                       : c < 0xF0 ? 3
+                       : c < 0xF5 ? 4
+                                  : 0;
+  if (length == 0 || i + length > text.size()) {
+    code = 0xFFFD;
+    return 1;
+  }
+  code = length == 1 ? c : c & (0xFF >> (length + 1));
+  for (std::size_t k = 1; k < length; ++k) {
+    unsigned char next = text[i + k];
+    if ((next & 0xC0) != 0x80) {
+      code = 0xFFFD;
+      return 1;
+    }
+    code = (code << 6) | (next & 0x3F);
+  }
+  return length;
+}
+
+// Terms are runs of ASCII letters and digits, lowercased, plus any other
+// characters outside ASCII so non-English words are indexed whole. Spaces
+// and punctuation from Latin-1, General Punctuation (curly quotes, dashes,
+// ellipsis, the typographic spaces) and CJK Symbols and Punctuation
+// separate terms, so "“hello”" is the term hello.
+bool is_term_char(char32_t c) {
+  if (c < 0x80) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9');
+  }
+  switch (c) {
+  case 0x00A0: // no-break space
+  case 0x00A1: // ¡
+  case 0x00A7: // §
+  case 0x00AB: // «
+  case 0x00B6: // ¶
+  case 0x00B7: // ·
+  case 0x00BB: // »
+  case 0x00BF: // ¿
+    return false;
+  }
+  return !(c >= 0x2000 && c <= 0x206F) && !(c >= 0x3000 && c <= 0x303F);
+}
+
+template <typename F> void tokenize(std::string_view text, F &&on_term) {
+  std::string term;
+  for (std::size_t i = 0; i <= text.size();) {
+    char32_t code = ' ';
+    std::size_t length = i < text.size() ? decode_utf8(text, i, code) : 1;
+    if (is_term_char(code)) {
+      if (code >= 'A' && code <= 'Z') {
+        term.push_back(char(code - 'A' + 'a'));
+      } else {
+        term.append(text.substr(i, length));
+      }
+      i += length;
+      continue;
+    }
+    i += length;
+    if (term.size() >= 2 && term.size() <= kMaxTermLength) {
+      on_term(term);
+    }
+    term.clear();
+  }
+}
+
+std::vector<std::string> query_terms(std::string_view query) {
+  std::vector<std::string> terms;
+  tokenize(query, [&](const std::string &term) { terms.push_back(term); });
+  std::sort(terms.begin(), terms.end());
+  terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+  return terms;
+}
+
+std::uint16_t day_slot(int month, int day) {
+  return static_cast<std::uint16_t>((month - 1) * 31 + (day - 1));
+}
+
+class Writer {
+public:
+  template <typename T> void put(T value) {
+    data_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+  void put_string(std::string_view s) {
+    put(static_cast<std::uint16_t>(s.size()));
+    data_.append(s);
+  }
+  const std::string &data() const { return data_; }
+
+private:
+  std::string data_;
+};
+
+class Reader {
+public:
+  explicit Reader(std::string_view data) : data_(data) {}
+
+  template <typename T> T get() {
+    T value{};
+    if (pos_ + sizeof(T) > data_.size()) {
+      ok_ = false;
+      return value;
+    }
+    std::memcpy(&value, data_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+  std::string_view get_string() {
+    auto len = get<std::uint16_t>();
+    if (!ok_ || pos_ + len > data_.size()) {
+      ok_ = false;
+      return {};
+    }
+    auto s = data_.substr(pos_, len);
+    pos_ += len;
+    return s;
+  }
+  bool ok() const { return ok_; }
+  bool at_end() const { return pos_ == data_.size(); }
+
+private:
+  std::string_view data_;
+  std::size_t pos_ = 0;
+  bool ok_ = true;
+};
+} // namespace
+
+std::string SearchIndex::index_path(const std::string &diary_dir) {
+  return diary_dir + "/.life-calendar-search.idx";
+}
+
+void SearchIndex::update(const std::string &diary_dir) {
+  // The persisted index is only read the first time; later updates start
+  // from the shards in memory, which are at least as recent
+  bool changed = false;
+  if (!loaded_) {
+    changed = !load(diary_dir);
+    loaded_ = true;
+  }
+
+  std::set<int> years;
+  std::error_code ec;
+  profile::count_open();
+  for (fs::directory_iterator it(diary_dir, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    int year = 0;
+    if (parse_diary_year_dir(it->path().filename().native(), year) &&
+        it->is_directory(ec)) {
+      years.insert(year);
+    }
+  }
+
+  std::erase_if(shards_, [&](const auto &item) {
+    bool removed = !years.contains(item.first);
+    changed = changed || removed;
+    return removed;
+  });
+
+  std::vector<Shard *> work;
+  for (int year : years) {
+    auto &shard = shards_[year];
+    shard.year = year;
+    work.push_back(&shard);
+  }
+
+  // One pool task per year directory
+  std::vector<char> shard_changed(work.size(), 0);
+  io_thread_pool().parallel_for(work.size(), [&](std::size_t i) {
+    shard_changed[i] = update_shard(diary_dir, *work[i]);
+  });
+
+  changed = changed || std::ranges::any_of(shard_changed,
+                                           [](char c) { return c != 0; });
+  if (changed) {
+    save(diary_dir);
+  }
+}
+
+bool SearchIndex::update_shard(const std::string &diary_dir, Shard &shard) {
+  std::string dir = get_diary_year_dir(shard.year, diary_dir);
+
+  std::map<std::uint16_t, FileStat> current;
+  std::error_code ec;
+  profile::count_open();
+  for (fs::directory_iterator it(dir, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    int y = 0, m = 0, d = 0;
+    FileStat stat;
+    if (parse_diary_filename(it->path().filename().native(), y, m, d) &&
+        y == shard.year && stat_file(it->path().native(), stat)) {
+      current[day_slot(m, d)] = stat;
+    }
+  }
+
+  // Slots whose old terms must go, and files that must be read
+  std::vector<std::uint16_t> stale;
+  for (const auto &[slot, stat] : shard.files) {
+    auto it = current.find(slot);
+    if (it == current.end() || it->second != stat) {
+      stale.push_back(slot);
+    }
+  }
+  std::vector<std::uint16_t> fresh;
+  for (const auto &[slot, stat] : current) {
+    auto it = shard.files.find(slot);
+    if (it == shard.files.end() || it->second != stat) {
+      fresh.push_back(slot);
+    }
+  }
+  if (stale.empty() && fresh.empty()) {
+    return false;
+  }
+
+  if (!stale.empty()) {
+    for (auto it = shard.postings.begin(); it != shard.postings.end();) {
+      std::erase_if(it->second, [&](std::uint16_t slot) {
+        return std::binary_search(stale.begin(), stale.end(), slot);
+      });
+      it = it->second.empty() ? shard.postings.erase(it) : std::next(it);
+    }
+  }
+
+  std::string text;
+  for (std::uint16_t slot : fresh) {
+    int month = slot / 31 + 1;
+    int day = slot % 31 + 1;
+    read_file(get_diary_path(shard.year, month, day, diary_dir), text);
+    std::set<std::string> terms;
+    tokenize(text, [&](const std::string &term) { terms.insert(term); });
+    for (const auto &term : terms) {
+      auto &list = shard.postings[term];
+      list.insert(std::lower_bound(list.begin(), list.end(), slot), slot);
+    }
+  }
+
+  shard.files = std::move(current);
+  return true;
+}
+
+std::vector<SearchIndex::Match>
+SearchIndex::search(std::string_view query) const {
+  std::vector<Match> matches;
+  auto terms = query_terms(query);
+  if (terms.empty()) {
+    return matches;
+  }
+
+  std::vector<std::uint16_t> hits, scratch;
+  for (auto it = shards_.rbegin(); it != shards_.rend(); ++it) {
+    const Shard &shard = it->second;
+    hits.clear();
+    for (std::size_t i = 0; i < terms.size(); ++i) {
+      auto p = shard.postings.find(terms[i]);
+      if (p == shard.postings.end()) {
+        hits.clear();
+        break;
+      }
+      if (i == 0) {
+        hits = p->second;
+      } else {
+        scratch.clear();
+        std::set_intersection(hits.begin(), hits.end(), p->second.begin(),
+                              p->second.end(), std::back_inserter(scratch));
+        hits.swap(scratch);
+      }
+      if (hits.empty()) {
+        break;
+      }
+    }
+    for (auto slot = hits.rbegin(); slot != hits.rend(); ++slot) {
+      matches.push_back({shard.year, *slot / 31 + 1, *slot % 31 + 1});
+    }
+  }
+  return matches;
+}
+
+std::string SearchIndex::snippet(const std::string &path,
+                                 std::string_view query) {
+  auto terms = query_terms(query);
+  profile::count_open();
+  std::ifstream ifs(path);
+  std::string line;
+  while (std::getline(ifs, line)) {
+    profile::count_bytes_read(line.size() + 1);
+    std::string lower = line;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) {
+      return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+    });
+    bool found = std::ranges::any_of(terms, [&](const std::string &term) {
+      return lower.find(term) != std::string::npos;
+    });
+    if (!found) {
+      continue;
+    }
+    line.erase(0, line.find_first_not_of(" \t#-*>"));
+    return fit_to_width(line, 64);
+  }
+  return "";
+}
+
+std::size_t SearchIndex::entry_count() const {
+  std::size_t count = 0;
+  for (const auto &[year, shard] : shards_) {
+    count += shard.files.size();
+  }
+  return count;
+}
+
+bool SearchIndex::load(const std::string &diary_dir) {
+  shards_.clear();
+
+  MappedFile file(index_path(diary_dir));
+  if (file.size() < sizeof(kMagic) ||
+      std::memcmp(file.data(), kMagic, sizeof(kMagic)) != 0) {
+    return false;
+  }
+
+  Reader in(file.view().substr(sizeof(kMagic)));
+  if (in.get<std::uint32_t>() != kVersion) {
+    return false;
+  }
+  auto shard_count = in.get<std::uint32_t>();
+  for (std::uint32_t s = 0; s < shard_count && in.ok(); ++s) {
+    Shard shard;
+    shard.year = in.get<std::int32_t>();
+
+    auto file_count = in.get<std::uint32_t>();
+    for (std::uint32_t f = 0; f < file_count && in.ok(); ++f) {
+      auto slot = in.get<std::uint16_t>();
+      FileStat stat;
+      stat.size = in.get<std::int64_t>();
+      stat.mtime_ns = in.get<std::int64_t>();
+      shard.files[slot] = stat;
+    }
+
+    auto term_count = in.get<std::uint32_t>();
+    for (std::uint32_t t = 0; t < term_count && in.ok(); ++t) {
+      auto &list = shard.postings[std::string(in.get_string())];
+      auto count = in.get<std::uint32_t>();
+      for (std::uint32_t i = 0; i < count && in.ok(); ++i) {
+        list.push_back(in.get<std::uint16_t>());
+      }
+    }
+    shards_[shard.year] = std::move(shard);
+  }
+
+  if (!in.ok() || !in.at_end()) {
+    shards_.clear();
+    return false;
+  }
+  return true;
+}
+
+bool SearchIndex::save(const std::string &diary_dir) const {
+  Writer out;
+  for (char c : kMagic) {
+    out.put(c);
+  }
+  out.put(kVersion);
+  out.put(static_cast<std::uint32_t>(shards_.size()));
+  for (const auto &[year, shard] : shards_) {
+    out.put(static_cast<std::int32_t>(year));
+    out.put(static_cast<std::uint32_t>(shard.files.size()));
+    for (const auto &[slot, stat] : shard.files) {
+      out.put(slot);
+      out.put(stat.size);
+      out.put(stat.mtime_ns);
+    }
+    out.put(static_cast<std::uint32_t>(shard.postings.size()));
+    for (const auto &[term, list] : shard.postings) {
+      out.put_string(term);
+      out.put(static_cast<std::uint32_t>(list.size()));
+      for (std::uint16_t slot : list) {
+        out.put(slot);
+      }
+    }
+  }
+  return write_file_atomically(index_path(diary_dir), out.data());
+}
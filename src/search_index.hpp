@@ -0,0 +1,60 @@
+#pragma once
+
+#include "diary.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Full-text index over the diary: term -> days whose entry contains it.
+// The index is split into one shard per year directory. Shards are
+// updated in parallel and persisted to diary_dir/.life-calendar-search.idx,
+// and only files whose mtime or size changed are read again.
+class SearchIndex {
+public:
+  // A day whose entry matches a query
+  struct Match {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+  };
+
+  // Path of the persisted index for diary_dir
+  [[nodiscard]] static std::string index_path(const std::string &diary_dir);
+
+  // Reindex changed files and save the index back if anything changed.
+  // The first update starts from the persisted index, later ones from
+  // the shards already in memory.
+  void update(const std::string &diary_dir);
+
+  // Days whose entry contains every term of the query, most recent first
+  [[nodiscard]] std::vector<Match> search(std::string_view query) const;
+
+  // First line of the file containing one of the query terms, fitted to
+  // 64 columns without splitting a UTF-8 sequence; empty if none does
+  [[nodiscard]] static std::string snippet(const std::string &path,
+                                           std::string_view query);
+
+  // Number of indexed entries
+  [[nodiscard]] std::size_t entry_count() const;
+
+private:
+  // One year directory. Days are stored as slots (month - 1) * 31 + day - 1.
+  struct Shard {
+    int year = 0;
+    // Indexed files with the stat they had when they were read
+    std::map<std::uint16_t, FileStat> files;
+    // term -> sorted slots of the files containing it
+    std::map<std::string, std::vector<std::uint16_t>, std::less<>> postings;
+  };
+
+  static bool update_shard(const std::string &diary_dir, Shard &shard);
+  bool load(const std::string &diary_dir);
+  bool save(const std::string &diary_dir) const;
+
+  std::map<int, Shard> shards_;
+  // Whether the persisted index has been read into shards_
+  bool loaded_ = false;
+};
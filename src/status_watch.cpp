@@ -0,0 +1,84 @@
+#include "status_watch.hpp"
+#include "clock.hpp"
+#include "date.hpp"
+#include "diary.hpp"
+#include "diary_watcher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <mutex>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+// Re-check this often even without events: it catches changes inotify
+// cannot report and a reader that went away, and costs one stat()
+constexpr auto kRecheckInterval = std::chrono::seconds(30);
+
+// Local midnight after the clock reading, as a system time
+std::chrono::system_clock::time_point
+next_midnight(const ClockSnapshot &clock) {
+  using namespace std::chrono;
+  auto tomorrow = floor<days>(clock.now) + days{1};
+  return current_zone()->to_sys(tomorrow, choose::earliest);
+}
+
+// True once the reading end of a stdout pipe is gone
+bool stdout_closed() {
+  pollfd pfd{STDOUT_FILENO, 0, 0};
+  return ::poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLERR | POLLHUP));
+}
+} // namespace
+
+int watch_diary_status(const Config &config, bool yesterday) {
+  // A status bar that goes away closes the pipe; notice it as a failed
+  // write instead of being killed
+  std::signal(SIGPIPE, SIG_IGN);
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool changed = false;
+
+  DiaryWatcher watcher;
+  watcher.start(config.diary_dir, [&](std::vector<DiaryChange>) {
+    {
+      std::lock_guard lock(mutex);
+      changed = true;
+    }
+    cv.notify_one();
+  });
+
+  int last = -1;
+  while (true) {
+    auto clock = take_clock_snapshot();
+    int y = 0, m = 0, d = 0;
+    date_from_epoch(clock.days - (yesterday ? 1 : 0), y, m, d);
+
+    FileStat stat;
+    int exists = stat_file(get_diary_path(y, m, d, config.diary_dir), stat);
+    if (exists != last) {
+      last = exists;
+      if (std::fputs(exists ? "true\n" : "false\n", stdout) < 0 ||
+          std::fflush(stdout) != 0) {
+        break;
+      }
+    }
+
+    auto deadline = std::min(next_midnight(clock),
+                             std::chrono::system_clock::now() +
+                                 kRecheckInterval);
+    std::unique_lock lock(mutex);
+    cv.wait_until(lock, deadline, [&] { return changed; });
+    changed = false;
+    if (stdout_closed()) {
+      break;
+    }
+  }
+
+  watcher.stop();
+  return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "config.hpp"
+
+// Print true/false for whether today's (or yesterday's) entry exists,
+// then print again whenever the answer changes: when an entry is created
+// or removed, or when the date rolls over at local midnight. Each line is
+// flushed for status bars that read continuously. Returns once stdout is
+// closed.
+int watch_diary_status(const Config &config, bool yesterday);
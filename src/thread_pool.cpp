@@ -0,0 +1,129 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(std::size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (std::size_t i = 0; i < threads; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (std::size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back([this, i] { run(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  auto &queue = *queues_[next_queue_.fetch_add(1) % queues_.size()];
+  // Counted before it can be taken, so the count never drops below the
+  // number of queued tasks and a take never finds it at zero
+  {
+    std::lock_guard lock(mutex_);
+    ++queued_;
+  }
+  {
+    std::lock_guard lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+bool ThreadPool::try_take(std::size_t index, std::function<void()> &task) {
+  // Own queue first, newest task first
+  {
+    auto &own = *queues_[index];
+    std::lock_guard lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  // Then steal the oldest task of another worker
+  for (std::size_t i = 1; i < queues_.size(); ++i) {
+    auto &other = *queues_[(index + i) % queues_.size()];
+    std::lock_guard lock(other.mutex);
+    if (!other.tasks.empty()) {
+      task = std::move(other.tasks.front());
+      other.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::run(std::size_t index) {
+  while (true) {
+    {
+      std::unique_lock lock(mutex_);
+      cv_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+      if (stopping_ && queued_ == 0) {
+        return;
+      }
+    }
+
+    std::function<void()> task;
+    if (try_take(index, task)) {
+      {
+        std::lock_guard lock(mutex_);
+        --queued_;
+      }
+      task();
+    }
+  }
+}
+
+void ThreadPool::parallel_for(std::size_t count,
+                              const std::function<void(std::size_t)> &fn) {
+  if (count == 0) {
+    return;
+  }
+
+  struct Batch {
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t remaining;
+  };
+  auto batch = std::make_shared<Batch>();
+  batch->remaining = count;
+
+  for (std::size_t i = 0; i < count; ++i) {
+    submit([batch, &fn, i] {
+      fn(i);
+      std::lock_guard lock(batch->mutex);
+      if (--batch->remaining == 0) {
+        batch->done.notify_all();
+      }
+    });
+  }
+
+  // Help out instead of blocking a thread that may itself be a worker
+  std::function<void()> task;
+  while (try_take(next_queue_.load() % queues_.size(), task)) {
+    {
+      std::lock_guard lock(mutex_);
+      --queued_;
+    }
+    task();
+  }
+
+  std::unique_lock lock(batch->mutex);
+  batch->done.wait(lock, [&] { return batch->remaining == 0; });
+}
+
+ThreadPool &io_thread_pool() {
+  static ThreadPool pool;
+  return pool;
+}
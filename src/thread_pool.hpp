@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing thread pool.
+// Every worker owns a task deque: it takes work from the back of its own
+// deque and, once that is empty, steals from the front of the others, so
+// a few slow directories on a high-latency mount do not leave the rest
+// of the workers idle.
+class ThreadPool {
+public:
+  // 0 threads means one per hardware core
+  explicit ThreadPool(std::size_t threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(std::function<void()> task);
+
+  // Run fn(i) for every i in [0, count) and wait for all of them.
+  // The calling thread runs queued tasks while it waits, so this is safe
+  // to call from inside a pool task.
+  void parallel_for(std::size_t count,
+                    const std::function<void(std::size_t)> &fn);
+
+  [[nodiscard]] std::size_t size() const { return threads_.size(); }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void run(std::size_t index);
+  bool try_take(std::size_t index, std::function<void()> &task);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<std::size_t> next_queue_{0};
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::size_t queued_ = 0;
+  bool stopping_ = false;
+};
+
+// Process-wide pool shared by the directory scanners
+ThreadPool &io_thread_pool();
@@ -0,0 +1,73 @@
+#include "ticker.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+Ticker::~Ticker() { stop(); }
+
+void Ticker::start(int ticks_per_second, Callback on_tick) {
+  stop();
+  if (ticks_per_second <= 0) {
+    return;
+  }
+
+  std::lock_guard lock(mutex_);
+  ticks_per_second_ = std::min(ticks_per_second, 1000);
+  on_tick_ = std::move(on_tick);
+  running_ = true;
+  thread_ = std::thread([this] { run(); });
+}
+
+void Ticker::stop() {
+  {
+    std::lock_guard lock(mutex_);
+    running_ = false;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void Ticker::set_suspended(bool suspended) {
+  {
+    std::lock_guard lock(mutex_);
+    suspended_ = suspended;
+  }
+  cv_.notify_all();
+}
+
+void Ticker::set_visible(bool visible) {
+  {
+    std::lock_guard lock(mutex_);
+    visible_ = visible;
+  }
+  cv_.notify_all();
+}
+
+void Ticker::run() {
+  using namespace std::chrono;
+  const auto period = duration_cast<system_clock::duration>(seconds(1)) /
+                      ticks_per_second_;
+
+  std::unique_lock lock(mutex_);
+  auto paused = [this] { return suspended_ || !visible_; };
+
+  while (running_) {
+    if (paused()) {
+      cv_.wait(lock, [&] { return !running_ || !paused(); });
+      continue;
+    }
+
+    // Sleep until the next multiple of the period on the wall clock
+    auto now = system_clock::now().time_since_epoch();
+    auto next = system_clock::time_point((now / period + 1) * period);
+    if (cv_.wait_until(lock, next, [&] { return !running_ || paused(); })) {
+      continue;
+    }
+
+    lock.unlock();
+    on_tick_();
+    lock.lock();
+  }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Calls a function on a background thread at every wall-clock tick
+// boundary (each whole second for a rate of 1), so the countdown never
+// drifts. Ticking pauses while the TUI is suspended or the countdown is
+// off-screen, and stop() returns without waiting for the next tick.
+class Ticker {
+public:
+  using Callback = std::function<void()>;
+
+  Ticker() = default;
+  ~Ticker();
+
+  Ticker(const Ticker &) = delete;
+  Ticker &operator=(const Ticker &) = delete;
+
+  // Start ticking ticks_per_second times per second, at most 1000. A rate
+  // of 0 never starts the thread.
+  void start(int ticks_per_second, Callback on_tick);
+
+  // Wake the thread and join it
+  void stop();
+
+  // Pause while an external program owns the terminal
+  void set_suspended(bool suspended);
+
+  // Pause while the countdown is not on screen
+  void set_visible(bool visible);
+
+private:
+  void run();
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool running_ = false;
+  bool suspended_ = false;
+  bool visible_ = true;
+  int ticks_per_second_ = 1;
+  Callback on_tick_;
+  std::thread thread_;
+};
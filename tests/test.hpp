@@ -0,0 +1,65 @@
+#pragma once
+
+// Small test harness shared by the tests/*.cpp suites.
+//
+// Each suite is a function taking the TestSuite; CHECK and CHECK_EQ
+// record a failure with its location and carry on, so one run reports
+// every broken case.
+
+#include <iostream>
+#include <string>
+#include <utility>
+
+class TestSuite {
+public:
+  // Start a named case; failures are reported under it
+  void begin(std::string name) {
+    name_ = std::move(name);
+    ++cases_;
+  }
+
+  void check(bool ok, const char *expr, const char *file, int line) {
+    ++checks_;
+    if (!ok) {
+      fail(expr, file, line);
+    }
+  }
+
+  template <typename A, typename B>
+  void check_eq(const A &actual, const B &expected, const char *expr,
+                const char *file, int line) {
+    ++checks_;
+    if (!(actual == expected)) {
+      fail(expr, file, line);
+      std::cerr << "    got:      " << actual << "\n"
+                << "    expected: " << expected << "\n";
+    }
+  }
+
+  [[nodiscard]] int cases() const { return cases_; }
+  [[nodiscard]] int checks() const { return checks_; }
+  [[nodiscard]] int failures() const { return failures_; }
+
+private:
+  void fail(const char *expr, const char *file, int line) {
+    ++failures_;
+    std::cerr << file << ":" << line << ": " << name_ << ": " << expr
+              << "\n";
+  }
+
+  std::string name_;
+  int cases_ = 0;
+  int checks_ = 0;
+  int failures_ = 0;
+};
+
+#define CHECK(expr)                                                           \
+  suite.check(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
+#define CHECK_EQ(actual, expected)                                            \
+  suite.check_eq((actual), (expected), #actual " == " #expected, __FILE__,    \
+                 __LINE__)
+
+void run_editor_tests(TestSuite &suite);
+void run_preview_tests(TestSuite &suite);
+void run_range_query_tests(TestSuite &suite);
+void run_stats_tests(TestSuite &suite);
@@ -0,0 +1,58 @@
+// split_command(): word splitting, quoting and escapes
+
+#include "editor.hpp"
+#include "test.hpp"
+
+#include <vector>
+
+namespace {
+// The words of command, each in brackets, or "<error>" when it does not
+// parse
+std::string split(std::string_view command) {
+  std::vector<std::string> argv;
+  if (!split_command(command, argv)) {
+    return "<error>";
+  }
+  std::string out;
+  for (const auto &arg : argv) {
+    out += "[" + arg + "]";
+  }
+  return out;
+}
+} // namespace
+
+void run_editor_tests(TestSuite &suite) {
+  suite.begin("split_command/blanks");
+  CHECK_EQ(split(""), "");
+  CHECK_EQ(split(" \t\n "), "");
+  CHECK_EQ(split("vi"), "[vi]");
+  CHECK_EQ(split("  nvim\t--clean  -R "), "[nvim][--clean][-R]");
+
+  suite.begin("split_command/single_quotes");
+  CHECK_EQ(split("'/opt/My Editor/edit' --wait"),
+           "[/opt/My Editor/edit][--wait]");
+  // Nothing is special inside single quotes, backslashes included
+  CHECK_EQ(split(R"('a\b "c"')"), R"([a\b "c"])");
+  CHECK_EQ(split("''"), "[]");
+  CHECK_EQ(split("pre'fix 'post"), "[prefix post]");
+
+  suite.begin("split_command/double_quotes");
+  CHECK_EQ(split(R"("my editor" -x)"), "[my editor][-x]");
+  // Only \" \\ \$ and \` are escapes inside double quotes
+  CHECK_EQ(split(R"("a\"b\\c\$d\`e")"), R"([a"b\c$d`e])");
+  CHECK_EQ(split(R"("a\nb")"), R"([a\nb])");
+  CHECK_EQ(split(R"("")"), "[]");
+
+  suite.begin("split_command/backslash");
+  CHECK_EQ(split(R"(my\ editor)"), "[my editor]");
+  CHECK_EQ(split(R"(a\'b)"), "[a'b]");
+  CHECK_EQ(split(R"(\\)"), R"([\])");
+  // Nothing is expanded
+  CHECK_EQ(split("$EDITOR ~/x *"), "[$EDITOR][~/x][*]");
+
+  suite.begin("split_command/unterminated");
+  CHECK_EQ(split("'open"), "<error>");
+  CHECK_EQ(split(R"("open)"), "<error>");
+  CHECK_EQ(split(R"("escaped end\")"), "<error>");
+  CHECK_EQ(split(R"(trailing\)"), "<error>");
+}
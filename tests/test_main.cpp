@@ -0,0 +1,16 @@
+// life-calendar-tests: runs every suite and exits non-zero if any check
+// failed.
+
+#include "test.hpp"
+
+int main() {
+  TestSuite suite;
+  run_editor_tests(suite);
+  run_preview_tests(suite);
+  run_range_query_tests(suite);
+  run_stats_tests(suite);
+
+  std::cout << suite.cases() << " cases, " << suite.checks() << " checks, "
+            << suite.failures() << " failed\n";
+  return suite.failures() == 0 ? 0 : 1;
+}
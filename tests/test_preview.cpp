@@ -0,0 +1,106 @@
+// fit_to_width() at the cut and PreviewDocument's line splitting
+
+#include "preview_document.hpp"
+#include "test.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+std::string temp_file(std::string_view name, std::string_view contents) {
+  std::string path = (fs::temp_directory_path() /
+                      ("life-calendar-tests-" + std::to_string(::getpid()) +
+                       "-" + std::string(name)))
+                         .native();
+  std::ofstream(path, std::ios::binary) << contents;
+  return path;
+}
+
+std::string line_of(PreviewDocument &document, std::size_t i) {
+  std::string_view line;
+  return document.line(i, line) ? std::string(line) : "<none>";
+}
+} // namespace
+
+void run_preview_tests(TestSuite &suite) {
+  suite.begin("fit_to_width/ascii");
+  CHECK_EQ(fit_to_width("hello", 10), "hello");
+  CHECK_EQ(fit_to_width("hello", 5), "hello");
+  CHECK_EQ(fit_to_width("hello world", 8), "hello...");
+  CHECK_EQ(fit_to_width("hello", 2), "..");
+  CHECK_EQ(fit_to_width("hello", 0), "");
+
+  suite.begin("fit_to_width/wide");
+  // Two columns each; the ellipsis goes where a whole glyph ends
+  CHECK_EQ(fit_to_width("日本語", 6), "日本語");
+  CHECK_EQ(fit_to_width("日本語テスト", 7), "日本...");
+  CHECK_EQ(fit_to_width("日本語", 5), "日...");
+  CHECK_EQ(fit_to_width("a😀b", 4), "a😀b");
+  CHECK_EQ(fit_to_width("a😀bcdef", 5), "a...");
+
+  suite.begin("fit_to_width/combining");
+  // e + U+0301 takes one column and is never split from its base
+  CHECK_EQ(fit_to_width("café!", 5), "café!");
+  CHECK_EQ(fit_to_width("abcd́efgh", 7), "abcd́...");
+  CHECK_EQ(fit_to_width("zero​width", 9), "zero​width");
+
+  suite.begin("fit_to_width/bytes");
+  CHECK_EQ(fit_to_width("a\xFF" "b", 5), "a\xEF\xBF\xBD" "b");
+  CHECK_EQ(fit_to_width("\xE6\x97", 5), "\xEF\xBF\xBD\xEF\xBF\xBD");
+  CHECK_EQ(fit_to_width("a\tb", 10), "a   b");
+  CHECK_EQ(fit_to_width("a\x01" "b", 10), "a b");
+
+  suite.begin("PreviewDocument/lines");
+  {
+    std::string path = temp_file("lines.md", "one\r\ntwo\n\nthree");
+    PreviewDocument document;
+    CHECK(document.open(path));
+    CHECK_EQ(line_of(document, 0), "one");
+    CHECK(!document.fully_indexed());
+    CHECK_EQ(document.line_count(), 4u);
+    CHECK_EQ(line_of(document, 1), "two");
+    CHECK_EQ(line_of(document, 2), "");
+    CHECK_EQ(line_of(document, 3), "three");
+    CHECK_EQ(line_of(document, 4), "<none>");
+    fs::remove(path);
+  }
+  {
+    std::string path = temp_file("trailing.md", "only\n");
+    PreviewDocument document;
+    CHECK(document.open(path));
+    CHECK_EQ(document.line_count(), 1u);
+    fs::remove(path);
+  }
+  {
+    std::string path = temp_file("empty.md", "");
+    PreviewDocument document;
+    CHECK(document.open(path));
+    CHECK_EQ(document.line_count(), 0u);
+    fs::remove(path);
+  }
+  CHECK(!PreviewDocument().open("/nonexistent/life-calendar/entry.md"));
+
+  suite.begin("PreviewDocument/large");
+  {
+    // Lines cross the chunk boundaries, and the file is cut short after
+    // the first chunk was read
+    std::string text;
+    for (int i = 0; text.size() < 3 * PreviewDocument::kChunk; ++i) {
+      text += "line " + std::to_string(i) + "\n";
+    }
+    std::string path = temp_file("large.md", text);
+    PreviewDocument document;
+    CHECK(document.open(path));
+    CHECK_EQ(line_of(document, 0), "line 0");
+    CHECK_EQ(line_of(document, 40000), "line 40000");
+    fs::resize_file(path, PreviewDocument::kChunk + 10);
+    std::size_t count = document.line_count();
+    CHECK(count > 40000);
+    CHECK(count < 60000);
+    fs::remove(path);
+  }
+}
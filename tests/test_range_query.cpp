@@ -0,0 +1,92 @@
+// parse_date_range() and write_range_query() across month and year ends
+
+#include "date.hpp"
+#include "range_query.hpp"
+#include "test.hpp"
+
+#include <cstdio>
+
+namespace {
+// Everything write_range_query() prints for the range
+std::string query(const DiaryIndex &index, std::string_view range,
+                  RangeFormat format) {
+  int from = 0, to = 0;
+  if (!parse_date_range(range, from, to)) {
+    return "<invalid>";
+  }
+  std::FILE *out = std::tmpfile();
+  if (!out || !write_range_query(index, from, to, format, out)) {
+    return "<failed>";
+  }
+  std::string text(static_cast<std::size_t>(std::ftell(out)), '\0');
+  std::rewind(out);
+  std::size_t n = std::fread(text.data(), 1, text.size(), out);
+  text.resize(n);
+  std::fclose(out);
+  return text;
+}
+
+bool parses(std::string_view range) {
+  int from = 0, to = 0;
+  return parse_date_range(range, from, to);
+}
+} // namespace
+
+void run_range_query_tests(TestSuite &suite) {
+  suite.begin("parse_date_range/valid");
+  int from = 0, to = 0;
+  CHECK(parse_date_range("2024-02-28..2024-03-01", from, to));
+  CHECK_EQ(from, days_from_epoch(2024, 2, 28));
+  CHECK_EQ(to - from, 2);
+  CHECK(parse_date_range("2023-12-31..2024-01-01", from, to));
+  CHECK_EQ(to - from, 1);
+  CHECK(parse_date_range("1970-01-01..1970-01-01", from, to));
+  CHECK_EQ(from, 0);
+  CHECK_EQ(to, 0);
+
+  suite.begin("parse_date_range/invalid");
+  CHECK(!parses("2024-01-02..2024-01-01")); // backwards
+  CHECK(!parses("2023-02-29..2023-03-01")); // not a leap year
+  CHECK(parses("2024-02-29..2024-03-01"));
+  CHECK(!parses("2024-04-31..2024-05-01"));
+  CHECK(!parses("2024-13-01..2024-13-02"));
+  CHECK(!parses("2024-01-01"));
+  CHECK(!parses("2024-01-01...2024-01-02"));
+  CHECK(!parses("2024-1-1..2024-1-2"));
+  CHECK(!parses(""));
+
+  DiaryIndex index;
+  index.set_diary(2023, 12, 31, true);
+  index.set_diary(2024, 1, 1, true);
+  index.set_diary(2024, 2, 29, true);
+
+  suite.begin("write_range_query/year_end");
+  CHECK_EQ(query(index, "2023-12-30..2024-01-02", RangeFormat::Csv),
+           "date,exists,size,mtime_ns\n"
+           "2023-12-30,false,,\n"
+           "2023-12-31,true,0,0\n"
+           "2024-01-01,true,0,0\n"
+           "2024-01-02,false,,\n");
+
+  suite.begin("write_range_query/leap_day");
+  CHECK_EQ(query(index, "2024-02-28..2024-03-01", RangeFormat::JsonLines),
+           "{\"date\":\"2024-02-28\",\"exists\":false,\"size\":null,"
+           "\"mtime_ns\":null}\n"
+           "{\"date\":\"2024-02-29\",\"exists\":true,\"size\":0,"
+           "\"mtime_ns\":0}\n"
+           "{\"date\":\"2024-03-01\",\"exists\":false,\"size\":null,"
+           "\"mtime_ns\":null}\n");
+
+  suite.begin("write_range_query/long");
+  // One row per day over several years, in order and without gaps
+  std::string csv = query(index, "2020-01-01..2027-12-31", RangeFormat::Csv);
+  std::size_t rows = 0;
+  for (char c : csv) {
+    rows += c == '\n';
+  }
+  int days = days_from_epoch(2027, 12, 31) - days_from_epoch(2020, 1, 1) + 1;
+  CHECK_EQ(rows, static_cast<std::size_t>(days) + 1); // and the header
+  CHECK(csv.ends_with("2027-12-31,false,,\n"));
+  CHECK(csv.find("2024-02-29,true") != std::string::npos);
+  CHECK(csv.find("2023-02-29") == std::string::npos);
+}
@@ -0,0 +1,83 @@
+// Streaks and entry counts from DiaryStats across month and year ends
+
+#include "date.hpp"
+#include "diary_stats.hpp"
+#include "test.hpp"
+
+namespace {
+// Mark every day of [from, to] as having an entry
+void write_days(DiaryIndex &index, int from, int to) {
+  for (int days = from; days <= to; ++days) {
+    int y = 0, m = 0, d = 0;
+    date_from_epoch(days, y, m, d);
+    index.set_diary(y, m, d, true);
+  }
+}
+} // namespace
+
+void run_stats_tests(TestSuite &suite) {
+  const int dec_28 = days_from_epoch(2023, 12, 28);
+  const int jan_3 = days_from_epoch(2024, 1, 3);
+  DiaryStats stats; // word counts stay empty; streaks come from the index
+
+  suite.begin("summary/streak_across_new_year");
+  {
+    DiaryIndex index;
+    write_days(index, dec_28, jan_3);
+    auto s = stats.summary(index, jan_3);
+    CHECK_EQ(s.longest_streak, 7);
+    CHECK_EQ(s.longest_streak_end, jan_3);
+    CHECK_EQ(s.current_streak, 7);
+    CHECK_EQ(s.first_entry, dec_28);
+    CHECK_EQ(s.overall_coverage, 1.0);
+  }
+
+  suite.begin("summary/streak_across_leap_day");
+  {
+    DiaryIndex index;
+    write_days(index, days_from_epoch(2024, 2, 27),
+               days_from_epoch(2024, 3, 2));
+    auto s = stats.summary(index, days_from_epoch(2024, 3, 10));
+    CHECK_EQ(s.longest_streak, 5);
+    CHECK_EQ(s.longest_streak_end, days_from_epoch(2024, 3, 2));
+    CHECK_EQ(s.current_streak, 0);
+  }
+
+  suite.begin("summary/longest_of_several");
+  {
+    DiaryIndex index;
+    // 3 days, a gap, then 40 days over a year end, a gap, then 2 days
+    write_days(index, days_from_epoch(2022, 6, 1),
+               days_from_epoch(2022, 6, 3));
+    int long_from = days_from_epoch(2022, 12, 1);
+    write_days(index, long_from, long_from + 39);
+    write_days(index, long_from + 45, long_from + 46);
+    auto s = stats.summary(index, long_from + 46);
+    CHECK_EQ(s.longest_streak, 40);
+    CHECK_EQ(s.longest_streak_end, long_from + 39);
+    CHECK_EQ(s.current_streak, 2);
+  }
+
+  suite.begin("current_streak/today_missing");
+  {
+    DiaryIndex index;
+    write_days(index, dec_28, jan_3 - 1);
+    // Today has no entry yet, so the run up to yesterday still counts
+    CHECK_EQ(current_streak(index, jan_3), 6);
+    CHECK_EQ(current_streak(index, jan_3 + 1), 0);
+  }
+
+  suite.begin("count_entries/years");
+  {
+    DiaryIndex index;
+    write_days(index, dec_28, jan_3);
+    CHECK_EQ(count_entries(index, dec_28, jan_3), 7);
+    CHECK_EQ(count_entries(index, days_from_epoch(2023, 1, 1),
+                           days_from_epoch(2023, 12, 31)),
+             4);
+    CHECK_EQ(count_entries(index, days_from_epoch(2024, 1, 2),
+                           days_from_epoch(2030, 1, 1)),
+             2);
+    CHECK_EQ(count_entries(index, jan_3, dec_28), 0);
+  }
+}